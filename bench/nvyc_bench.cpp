@@ -0,0 +1,278 @@
+#include "generation/Lexer.hpp"
+#include "generation/Parser.hpp"
+#include "generation/LLVMEmission.hpp"
+#include "passes/PassManager.hpp"
+#include "processing/StreamRebuilder.hpp"
+#include "utils/CompilationContext.hpp"
+#include "utils/CompileStats.hpp"
+#include "utils/EmissionBuilder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    nvyc_bench: end-to-end compile throughput.
+
+    Generates synthetic nvy programs over a grid of sizes (lines, functions,
+    expression nesting depth), runs each through the full front end and
+    emitter (Lexer -> lexical passes -> Parser -> parsing passes ->
+    compilation passes -> compile()) and writes lines/sec per phase as JSON.
+
+    Per phase it also fits the log-log slope of time against input size, so
+    anything superlinear shows up as an exponent well above 1.
+
+    Usage: nvyc_bench [-o <file>] [--max-lines <n>] [--repeat <n>] [--plot]
+
+    The JSON goes to a file (nvyc_bench.json by default) since the parser
+    still logs to stdout. Schema, version 1:
+    {
+        "schema": 1,
+        "cases": [{"lines", "functions", "depth", "total_ms", "lines_per_sec",
+                   "phases": {name: {"wall_ms", "lines_per_sec"}}}],
+        "scaling": {depth: {phase: exponent}}
+    }
+*/
+
+namespace {
+
+    struct BenchCase {
+        uint64_t lines;
+        uint64_t functions;
+        int depth;
+    };
+
+    struct BenchResult {
+        BenchCase config;
+        uint64_t actualLines;
+        double totalMs;
+        uint64_t emittedFunctions;
+        std::map<std::string, double> phaseMs; // Top-level phases only
+    };
+
+    // Phases reported by the pipeline, in order, plus the overall total
+    const std::vector<std::string> PHASES = {
+        "lex", "lexicalPasses", "parse", "parsingPasses", "compilationPasses", "emit"
+    };
+
+    // 1k to 1M lines, 10 to 100k functions, each at a shallow, medium and deep nesting
+    std::vector<BenchCase> benchGrid(uint64_t maxLines) {
+        const std::vector<std::pair<uint64_t, uint64_t>> sizes = {
+            {1000, 10}, {10000, 100}, {100000, 1000}, {1000000, 10000}, {1000000, 100000}
+        };
+
+        std::vector<BenchCase> grid;
+        for(int depth : {1, 4, 16}) {
+            for(const auto& size : sizes) {
+                if(size.first <= maxLines) grid.push_back(BenchCase{size.first, size.second, depth});
+            }
+        }
+        return grid;
+    }
+
+    // (a + (b * (x0 - ... ))) nested depth levels
+    std::string nestedExpression(int depth, int seed, const std::string& last) {
+        static const char* ops[] = {"+", "-", "*"};
+        std::string expr = last;
+        for(int i = 0; i < depth; i++) {
+            std::string operand = (i + seed) % 2 ? "a" : "b";
+            expr = "(" + operand + " " + ops[(i + seed) % 3] + " " + expr + ")";
+        }
+        return expr;
+    }
+
+    /*
+        public func f0(int32 a, int32 b) -> int32 {
+            let x0 = (a + b);
+            let x1 = (b - (a + x0));
+            return x1;
+        }
+
+        Every function is public, so each one is a root for dead-function
+        elimination and keeps external linkage. The emitter sees the whole
+        program, and runCase checks that it did.
+    */
+    std::vector<std::string> generateProgram(const BenchCase& config) {
+        std::vector<std::string> lines;
+        lines.reserve(config.lines + config.functions);
+
+        uint64_t bodyLines = config.lines / config.functions;
+        uint64_t statements = bodyLines > 3 ? bodyLines - 3 : 1;
+
+        for(uint64_t f = 0; f < config.functions; f++) {
+            lines.push_back("public func f" + std::to_string(f) + "(int32 a, int32 b) -> int32 {");
+
+            std::string last = "b";
+            for(uint64_t s = 0; s < statements; s++) {
+                std::string var = "x" + std::to_string(s);
+                lines.push_back("    let " + var + " = " + nestedExpression(config.depth, s + f, last) + ";");
+                last = var;
+            }
+
+            lines.push_back("    return " + last + ";");
+            lines.push_back("}");
+        }
+        return lines;
+    }
+
+    BenchResult runCase(const BenchCase& config) {
+        std::vector<std::string> lines = generateProgram(config);
+
+        nvyc::CompilationContext context("bench");
+        context.getStats().enableTiming(nvyc::CompileStats::Format::JSON);
+
+        uint64_t emittedFunctions = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            nvyc::Processing::StreamRebuilder rebuilder(lines);
+            nvyc::Passes::PassManager passes(context, rebuilder);
+
+            std::unique_ptr<nvyc::NodeStream> stream(nvyc::Lexer::getInstance().lex(context, lines));
+            passes.executeLexicalPasses(*stream);
+
+            nvyc::Parser parser(context);
+            std::vector<std::unique_ptr<NASTNode>> nodes = parser.parseStream(*stream);
+            stream.reset();
+
+            for(auto& node : nodes) {
+                node = passes.executeParsingPasses(std::move(node));
+            }
+            passes.executeCompilationPasses(nodes);
+
+            nvyc::EmissionBuilder builder(context, "bench");
+            nvyc::compile(&builder, nodes);
+
+            for(const llvm::Function& func : *builder.getModule()) {
+                if(!func.isDeclaration()) emittedFunctions++;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        BenchResult result{config, lines.size(), std::chrono::duration<double, std::milli>(end - start).count(), emittedFunctions, {}};
+        for(const auto& phase : context.getStats().getPhases()) {
+            if(phase.depth == 0) result.phaseMs[phase.name] += phase.wallMs;
+        }
+        return result;
+    }
+
+    double linesPerSec(uint64_t lines, double ms) {
+        return ms > 0 ? lines / (ms / 1000.0) : 0;
+    }
+
+    double phaseTime(const BenchResult& result, const std::string& phase) {
+        if(phase == "total") return result.totalMs;
+        auto it = result.phaseMs.find(phase);
+        return it == result.phaseMs.end() ? 0 : it->second;
+    }
+
+    void writeJson(std::ostream& os, const std::vector<BenchResult>& results) {
+        std::vector<std::string> phases = PHASES;
+        phases.push_back("total");
+
+        os << "{\n  \"schema\": 1,\n  \"cases\": [\n";
+        for(size_t i = 0; i < results.size(); i++) {
+            const BenchResult& result = results[i];
+            os << "    {\"lines\": " << result.actualLines << ", \"functions\": " << result.config.functions
+               << ", \"depth\": " << result.config.depth << ", \"total_ms\": " << result.totalMs
+               << ", \"lines_per_sec\": " << linesPerSec(result.actualLines, result.totalMs) << ", \"phases\": {";
+
+            for(size_t p = 0; p < PHASES.size(); p++) {
+                double ms = phaseTime(result, PHASES[p]);
+                if(p) os << ", ";
+                os << "\"" << PHASES[p] << "\": {\"wall_ms\": " << ms << ", \"lines_per_sec\": " << linesPerSec(result.actualLines, ms) << "}";
+            }
+            os << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        // One curve per depth, so nesting cost doesn't skew the size exponent
+        std::map<int, std::vector<const BenchResult*>> byDepth;
+        for(const BenchResult& result : results) byDepth[result.config.depth].push_back(&result);
+
+        os << "  ],\n  \"scaling\": {";
+        bool firstDepth = true;
+        for(const auto& [depth, curve] : byDepth) {
+            os << (firstDepth ? "" : ",") << "\n    \"" << depth << "\": {";
+            firstDepth = false;
+
+            for(size_t p = 0; p < phases.size(); p++) {
+                std::vector<std::pair<double, double>> points;
+                for(const BenchResult* result : curve) points.emplace_back(result->actualLines, phaseTime(*result, phases[p]));
+                if(p) os << ", ";
+                os << "\"" << phases[p] << "\": " << nvyc::CompileStats::scalingExponent(points);
+            }
+            os << "}";
+        }
+        os << "\n  }\n}\n";
+    }
+
+    /*
+        Text plot of lines/sec against input size, one row per case:
+        depth  4      1000 lines |##########################   812345 l/s
+        A throughput bar that shrinks as the input grows is superlinear work.
+    */
+    void plotScaling(std::ostream& os, const std::vector<BenchResult>& results) {
+        double best = 0;
+        for(const BenchResult& result : results) best = std::max(best, linesPerSec(result.actualLines, result.totalMs));
+        if(best == 0) return;
+
+        for(const BenchResult& result : results) {
+            double rate = linesPerSec(result.actualLines, result.totalMs);
+            int width = int(50 * rate / best);
+            os << "depth " << std::setw(2) << result.config.depth << std::setw(10) << result.actualLines << " lines |"
+               << std::string(width, '#') << std::string(50 - width, ' ') << std::setw(12) << uint64_t(rate) << " l/s\n";
+        }
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output = "nvyc_bench.json";
+    uint64_t maxLines = 1000000;
+    int repeat = 1;
+    bool plot = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if(arg == "--max-lines" && i + 1 < argc) maxLines = std::stoull(argv[++i]);
+        else if(arg == "--repeat" && i + 1 < argc) repeat = std::max(1, std::stoi(argv[++i]));
+        else if(arg == "--plot") plot = true;
+        else {
+            std::cerr << "Usage: nvyc_bench [-o <file>] [--max-lines <n>] [--repeat <n>] [--plot]\n";
+            return 1;
+        }
+    }
+
+    // Best of N per case, the minimum is the least noisy estimate of the real cost
+    std::vector<BenchResult> results;
+    for(const BenchCase& config : benchGrid(maxLines)) {
+        BenchResult best = runCase(config);
+        for(int r = 1; r < repeat; r++) {
+            BenchResult next = runCase(config);
+            if(next.totalMs < best.totalMs) best = next;
+        }
+        // An emptied module would make every emit/optimize number meaningless
+        if(best.emittedFunctions != config.functions) {
+            std::cerr << "nvyc_bench: emitted " << best.emittedFunctions << " of " << config.functions
+                      << " functions for " << config.lines << " lines at depth " << config.depth << "\n";
+            return 1;
+        }
+        results.push_back(best);
+    }
+
+    std::ofstream file(output);
+    if(!file) {
+        std::cerr << "nvyc_bench: cannot write " << output << "\n";
+        return 1;
+    }
+    writeJson(file, results);
+
+    if(plot) plotScaling(std::cerr, results);
+    return 0;
+}
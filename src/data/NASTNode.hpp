@@ -3,11 +3,16 @@
 #include "NodeType.hpp"
 #include "NodeStream.hpp"
 #include "Symbols.hpp"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iostream>
 
+namespace llvm {
+    class Type;
+}
+
 namespace nvyc {
 
     class NASTNode {
@@ -18,6 +23,11 @@ namespace nvyc {
             Value dptr;
             bool owned;
 
+            // Type annotations, set once by annotateTypes so the emitter doesn't re-infer per use
+            NodeType resolvedType = NodeType::INVALID;
+            mutable llvm::Type* nativeType = nullptr; // Cached by the emitter, tied to its LLVMContext
+            mutable uint32_t symbolId = UINT32_MAX;   // Interned name, tied to the emitter's SymbolStorage
+
         public:
             NASTNode(NodeType t, Value p, bool owned = true) : dptr(p), type(t), owned(owned) {}
             ~NASTNode() = default;
@@ -43,6 +53,30 @@ namespace nvyc {
                 dptr = v;
             }
 
+            NodeType getResolvedType() const {
+                return resolvedType;
+            }
+
+            void setResolvedType(NodeType t) {
+                resolvedType = t;
+            }
+
+            llvm::Type* getNativeType() const {
+                return nativeType;
+            }
+
+            void setNativeType(llvm::Type* t) const {
+                nativeType = t;
+            }
+
+            uint32_t getSymbolId() const {
+                return symbolId;
+            }
+
+            void setSymbolId(uint32_t id) const {
+                symbolId = id;
+            }
+
             bool isOwned() const {
                     return owned;
             }
@@ -68,6 +102,17 @@ namespace nvyc {
                     return subnodes.at(node).get(); // Automatically throws error if OOB
             }
 
+            // Whole subtree: nodes and child arrays, plus the string payloads they own
+            void memoryUsage(MemoryUsage& nodeUsage, MemoryUsage& stringUsage) const {
+                nodeUsage.add(sizeof(NASTNode));
+                if(subnodes.capacity()) nodeUsage.add(subnodes.capacity() * sizeof(std::unique_ptr<NASTNode>));
+                stringUsage.addString(dptr.str);
+
+                for(const auto& subnode : subnodes) {
+                    if(subnode) subnode->memoryUsage(nodeUsage, stringUsage);
+                }
+            }
+
             std::string asString() const {
                     return asStringHelper("", "");
             }
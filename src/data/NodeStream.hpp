@@ -4,12 +4,15 @@
 #include "data/Symbols.hpp"
 #include "data/Value.hpp"
 #include "error/Error.hpp"
+#include "utils/MemoryStats.hpp"
 #include "data/Symbols.hpp"
 #include <cstddef>
 #include <functional>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include <vector>
 #include <iostream>
 
 namespace nvyc {
@@ -23,15 +26,15 @@ namespace nvyc {
 
                 Token(Value v, NodeType ty, int l) : type(ty), val(v), line(l) {}
 
-                Value getValue() {
+                const Value& getValue() const {
                     return val;
                 }
 
-                NodeType getType() {
+                NodeType getType() const {
                     return type;
                 }
 
-                int getLine() {
+                int getLine() const {
                     return line;
                 }
             };
@@ -39,6 +42,27 @@ namespace nvyc {
             std::vector<Token> tokens;
             size_t idx = 0;
 
+            // Closing index for every '(' and '{', built on first use and dropped whenever tokens change
+            mutable std::vector<int> matches;
+
+            void buildMatches() const {
+                matches.assign(tokens.size(), -1);
+                std::vector<int> parens, braces;
+                for(size_t i = 0; i < tokens.size(); i++) {
+                    switch(tokens[i].type) {
+                        case NodeType::OPENPARENS: parens.push_back(i); break;
+                        case NodeType::OPENBRACE:  braces.push_back(i); break;
+                        case NodeType::CLOSEPARENS:
+                            if(!parens.empty()) { matches[parens.back()] = i; parens.pop_back(); }
+                            break;
+                        case NodeType::CLOSEBRACE:
+                            if(!braces.empty()) { matches[braces.back()] = i; braces.pop_back(); }
+                            break;
+                        default: break;
+                    }
+                }
+            }
+
             struct StreamCursor {
                 const std::vector<Token>& tok_ref;
                 size_t idx_it = 0;
@@ -89,21 +113,20 @@ namespace nvyc {
                     return t;
                 }
 
-                Token peek(size_t dist) {
+                // Accessors hand out references, copying a Token copies its string payload
+                const Token& peek(size_t dist) const {
                     if(dist + idx_it > tok_ref.size()) {
                         nvyc::Error::nvyerr_failcompile(1, "Attempted to peek at a token out of bounds");
                     }
-                    Token t = tok_ref[dist + idx_it];
-                    return t;
+                    return tok_ref[dist + idx_it];
                 }
 
-                Token behind(size_t dist) {
+                const Token& behind(size_t dist) const {
                     if(dist > idx_it) dist = idx_it;
-                    Token t = tok_ref[idx_it - dist];
-                    return t;
+                    return tok_ref[idx_it - dist];
                 }
 
-                Token get() {
+                const Token& get() const {
                     if(idx_it < 0 || idx_it > tok_ref.size()) {
                         nvyc::Error::nvyerr_failcompile(1, "Attempted to access token out of bounds");
                     }
@@ -120,6 +143,14 @@ namespace nvyc {
 
             void addNode(NodeType type, Value val, int line) {
                 tokens.push_back(Token(val, type, line));
+                matches.clear();
+            }
+
+            // Index of the ')' or '}' that closes the delimiter at i, -1 if it is unbalanced or not an opener
+            int matchingDelimiter(int i) const {
+                if(i < 0 || (size_t) i >= tokens.size()) return -1;
+                if(matches.size() != tokens.size()) buildMatches();
+                return matches[i];
             }
 
             Value getValue(int i = -1) const {
@@ -164,20 +195,41 @@ namespace nvyc {
                 return tokens.size();
             }
 
+            int getIndex() const {
+                return idx;
+            }
+
+            // Token array and the string payloads it owns, for -fmem-report
+            void memoryUsage(MemoryUsage& tokenUsage, MemoryUsage& stringUsage) const {
+                if(tokens.capacity()) tokenUsage.add(tokens.capacity() * sizeof(Token));
+                for(const Token& tok : tokens) stringUsage.addString(tok.val.str);
+            }
+
             void setToken(Token tok, int idx) {
                 tokens[idx] = tok;
+                matches.clear();
             }
 
+            // Removes [idx, idy) with a single shift of the tail
             void delTokens(int idx, int idy) {
-                int i = idx;
-                while(i < idy) {
-                    tokens.erase(tokens.begin() + idx);
-                    i++;
-                }
+                if(idy <= idx) return;
+                tokens.erase(tokens.begin() + idx, tokens.begin() + idy);
+                matches.clear();
+            }
+
+            // Hands the first count tokens to dest, used to cut a declaration off a lexing window
+            void moveFront(int count, NodeStream& dest) {
+                if(count <= 0) return;
+                dest.tokens.insert(dest.tokens.end(), std::make_move_iterator(tokens.begin()), std::make_move_iterator(tokens.begin() + count));
+                tokens.erase(tokens.begin(), tokens.begin() + count);
+                idx = idx > (size_t) count ? idx - count : 0;
+                matches.clear();
+                dest.matches.clear();
             }
 
             void insertToken(Token tok, int idx) {
                 tokens.insert(tokens.begin() + idx, tok);
+                matches.clear();
             }
 
             void backward(int limit = -1) {
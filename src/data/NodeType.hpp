@@ -64,7 +64,9 @@ enum class NodeType {
 
     DIRECTIVE, DIRTYPE, DIRVALUE,                       // Directives
     DIRIMPORT, DIRLIBDEF, DIRPRIVATE, DIRALIAS,
-    DIRUSERTYPE
+    DIRUSERTYPE,
+
+    NODETYPE_COUNT                                      // Must remain last
 }; // NodeType
 
 } // namespace nvyc
\ No newline at end of file
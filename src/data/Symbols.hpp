@@ -4,283 +4,298 @@
 #include <string>
 #include <cstdint>
 #include <sstream>
-#include <unordered_set>
+#include <array>
+#include <cstddef>
+#include <vector>
 
 namespace nvyc::symbols {
 
-    inline const std::unordered_set<NodeType> TYPE_SYMBOLS = {
-        NodeType::INT32_T, NodeType::INT64_T,
-        NodeType::FP32_T, NodeType::FP64_T,
-        NodeType::STR_T, NodeType::CHAR_T,
-        NodeType::VOID_T, NodeType::BOOL_T,
-        NodeType::TYPE_T, NodeType::FUNCTION_T
-    };
-
-    inline const std::unordered_set<NodeType> START_SYMBOLS = {
-        NodeType::VARDEF, NodeType::FUNCTION, NodeType::IF,
-        NodeType::ELSE, NodeType::FORLOOP, NodeType::WHILELOOP,
-        NodeType::NATIVE, NodeType::PUBLIC, NodeType::PRIVATE,
-        NodeType::FINAL, NodeType::CONSTANT, NodeType::STRUCT,
-        NodeType::RETURN, NodeType::MODULE
-    };
-
-    inline const std::unordered_set<NodeType> BRACES = {
-        NodeType::OPENBRACE, NodeType::CLOSEBRACE, 
-    };
+    /*
+        Every NodeType gets one row of traits, indexed by the enum value.
+        Classification on the lexer/parser/emitter hot paths is a single
+        load and mask instead of a hash set probe.
+    */
+    namespace trait {
+        static constexpr uint16_t LITERAL             = 1 << 0;
+        static constexpr uint16_t TYPE                = 1 << 1;
+        static constexpr uint16_t START               = 1 << 2;   // Start of a statement
+        static constexpr uint16_t BRACE               = 1 << 3;
+        static constexpr uint16_t UNARY               = 1 << 4;
+        static constexpr uint16_t MEMORY              = 1 << 5;
+        static constexpr uint16_t ARITH               = 1 << 6;
+        static constexpr uint16_t LOGIC               = 1 << 7;
+        static constexpr uint16_t BITWISE             = 1 << 8;
+        static constexpr uint16_t MEMORY_CANDIDATE    = 1 << 9;
+        static constexpr uint16_t PREFIX              = 1 << 10;  // Can be a prefix operator, see unary
+
+        static constexpr uint16_t OPERATOR = ARITH | LOGIC | BITWISE;
+    }
 
-    inline const std::unordered_set<NodeType> LITERAL_SYMBOLS = {
-        NodeType::INT32, NodeType::INT64, NodeType::FP32,
-        NodeType::FP64, NodeType::STR, NodeType::CHAR,
-        NodeType::SHORT
+    struct NodeTraits {
+        const char* name = nullptr;
+        uint16_t flags = 0;
+        uint8_t precedence = 0;
+        NodeType unary = NodeType::INVALID;
     };
 
-    inline const std::unordered_set<NodeType> UNARY_SYMBOLS = {
-        NodeType::SWITCHSIGN, NodeType::PTRDEREF, NodeType::FINDADDRESS
-    };
+    static constexpr size_t NODETYPE_COUNT = static_cast<size_t>(NodeType::NODETYPE_COUNT);
+
+    constexpr std::array<NodeTraits, NODETYPE_COUNT> buildTraitTable() {
+        using namespace trait;
+        std::array<NodeTraits, NODETYPE_COUNT> table{};
+
+        auto set = [&table](NodeType t, const char* name, uint16_t flags, uint8_t precedence = 0, NodeType unary = NodeType::INVALID) {
+            table[static_cast<size_t>(t)] = NodeTraits{name, flags, precedence, unary};
+        };
+
+        set(NodeType::VARDEF,          "VARDEF",          START);
+        set(NodeType::VARIABLE,        "VARIABLE",        MEMORY);
+        set(NodeType::REDEF,           "REDEF",           0);
+        set(NodeType::ASSIGN,          "ASSIGN",          0);
+        set(NodeType::GLOBALVARDEF,    "GLOBALVARDEF",    0);
+        set(NodeType::ADD,             "ADD",             ARITH, 11);
+        set(NodeType::SUB,             "SUB",             ARITH | PREFIX, 11, NodeType::SWITCHSIGN);
+        set(NodeType::MUL,             "MUL",             ARITH | MEMORY_CANDIDATE | PREFIX, 12, NodeType::PTRDEREF);
+        set(NodeType::DIV,             "DIV",             ARITH, 12);
+        set(NodeType::LT,              "LT",              LOGIC, 9);
+        set(NodeType::GT,              "GT",              LOGIC, 9);
+        set(NodeType::GTE,             "GTE",             LOGIC, 9);
+        set(NodeType::LTE,             "LTE",             LOGIC, 9);
+        set(NodeType::EQ,              "EQ",              LOGIC, 8);
+        set(NodeType::NEQ,             "NEQ",             LOGIC, 8);
+        set(NodeType::MODULO,          "MODULO",          ARITH, 12);
+        set(NodeType::LOOPDEF,         "LOOPDEF",         0);
+        set(NodeType::LOOPCOND,        "LOOPCOND",        0);
+        set(NodeType::FORLOOP,         "FORLOOP",         START);
+        set(NodeType::WHILELOOP,       "WHILELOOP",       START);
+        set(NodeType::LOOPITERATION,   "LOOPITERATION",   0);
+        set(NodeType::INT32,           "INT32",           LITERAL);
+        set(NodeType::INT64,           "INT64",           LITERAL);
+        set(NodeType::FP32,            "FP32",            LITERAL);
+        set(NodeType::FP64,            "FP64",            LITERAL);
+        set(NodeType::STR,             "STR",             LITERAL);
+        set(NodeType::CHAR,            "CHAR",            LITERAL);
+        set(NodeType::BOOL_TR,         "BOOL_TR",         0);
+        set(NodeType::UNIFIED,         "UNIFIED",         0);
+        set(NodeType::SINGULAR,        "SINGULAR",        0);
+        set(NodeType::TYPE,            "TYPE",            0);
+        set(NodeType::VOID,            "VOID",            0);
+        set(NodeType::BOOL_FA,         "BOOL_FA",         0);
+        set(NodeType::NUM32,           "NUM32",           0);
+        set(NodeType::NUM64,           "NUM64",           0);
+        set(NodeType::NUMBER,          "NUMBER",          0);
+        set(NodeType::ARRAY_TYPE,      "ARRAY_TYPE",      0);
+        set(NodeType::MAP,             "MAP",             0);
+        set(NodeType::FUNCTIONCHAIN,   "FUNCTIONCHAIN",   0);
+        set(NodeType::UNSIGNED,        "UNSIGNED",        0);
+        set(NodeType::STRUCT,          "STRUCT",          START);
+        set(NodeType::BOOL,            "BOOL",            0);
+        set(NodeType::SHORT,           "SHORT",           LITERAL);
+        set(NodeType::RAWBIN,          "RAWBIN",          0);
+        set(NodeType::RAWHEX,          "RAWHEX",          0);
+        set(NodeType::ARRAY_SIZE,      "ARRAY_SIZE",      0);
+        set(NodeType::ARRAY,           "ARRAY",           0);
+        set(NodeType::ARRAY_ACCESS,    "ARRAY_ACCESS",    0);
+        set(NodeType::ARRAY_INDEX,     "ARRAY_INDEX",     0);
+        set(NodeType::OPAQUE_PTR_T,    "OPAQUE_PTR_T",    0);
+        set(NodeType::FCONST_T,        "FCONST_T",        0);
+        set(NodeType::BOX_OWNED,       "BOX_OWNED",       0);
+        set(NodeType::BOX_GLASS,       "BOX_GLASS",       0);
+        set(NodeType::BOX_LOCKED,      "BOX_LOCKED",      0);
+        set(NodeType::BOX_EMPTY,       "BOX_EMPTY",       0);
+        set(NodeType::BOX_OPAQUE,      "BOX_OPAQUE",      0);
+        set(NodeType::FINAL,           "FINAL",           START);
+        set(NodeType::STATIC,          "STATIC",          START);
+        set(NodeType::PUBLIC,          "PUBLIC",          START);
+        set(NodeType::PRIVATE,         "PRIVATE",         START);
+        set(NodeType::IMPLICIT,        "IMPLICIT",        0);
+        set(NodeType::CONSTANT,        "CONSTANT",        START);
+        set(NodeType::NATIVE,          "NATIVE",          START);
+        set(NodeType::MODULE,          "MODULE",          START);
+        set(NodeType::FUNCTION_T,      "FUNCTION_T",      TYPE);
+        set(NodeType::INT32_T,         "INT32_T",         TYPE);
+        set(NodeType::INT64_T,         "INT64_T",         TYPE);
+        set(NodeType::FP32_T,          "FP32_T",          TYPE);
+        set(NodeType::FP64_T,          "FP64_T",          TYPE);
+        set(NodeType::STRING_T,        "STRING_T",        0);
+        set(NodeType::CHAR_T,          "CHAR_T",          TYPE);
+        set(NodeType::BOOL_T,          "BOOL_T",          TYPE);
+        set(NodeType::STR_T,           "STR_T",           TYPE);
+        set(NodeType::TYPE_T,          "TYPE_T",          TYPE);
+        set(NodeType::USERTYPE_T,      "USERTYPE_T",      0);
+        set(NodeType::CAST,            "CAST",            0);
+        set(NodeType::VOID_T,          "VOID_T",          TYPE);
+        set(NodeType::STAR,            "STAR",            0);
+        set(NodeType::FUNCTION_STAR,   "FUNCTION_STAR",   0);
+        set(NodeType::INT32_STAR,      "INT32_STAR",      0);
+        set(NodeType::INT64_STAR,      "INT64_STAR",      0);
+        set(NodeType::FP32_STAR,       "FP32_STAR",       0);
+        set(NodeType::FP64_STAR,       "FP64_STAR",       0);
+        set(NodeType::UNIFIED_STAR,    "UNIFIED_STAR",    0);
+        set(NodeType::STRING_STAR,     "STRING_STAR",     0);
+        set(NodeType::CHAR_STAR,       "CHAR_STAR",       0);
+        set(NodeType::BOOL_STAR,       "BOOL_STAR",       0);
+        set(NodeType::STR_STAR,        "STR_STAR",        0);
+        set(NodeType::TYPE_STAR,       "TYPE_STAR",       0);
+        set(NodeType::USERTYPE_STAR,   "USERTYPE_STAR",   0);
+        set(NodeType::CAST_STAR,       "CAST_STAR",       0);
+        set(NodeType::VOID_STAR,       "VOID_STAR",       0);
+        set(NodeType::STRUCT_STAR,     "STRUCT_STAR",     0);
+        set(NodeType::PTR_TYPE,        "PTR_T",           0);
+        set(NodeType::OPENPARENS,      "OPENPARENS",      0);
+        set(NodeType::CLOSEPARENS,     "CLOSEPARENS",     0);
+        set(NodeType::OPENBRKT,        "OPENBRKT",        0);
+        set(NodeType::CLOSEBRKT,       "CLOSEBRKT",       0);
+        set(NodeType::ENDOFLINE,       "ENDOFLINE",       0);
+        set(NodeType::COMMADELIMIT,    "COMMADELIMIT",    0);
+        set(NodeType::SQUOTE,          "SQUOTE",          0);
+        set(NodeType::DQUOTE,          "DQUOTE",          0);
+        set(NodeType::COMMENT,         "COMMENT",         0);
+        set(NodeType::MLCOMMENTSTART,  "MLCOMMENTSTART",  0);
+        set(NodeType::MLCOMMENTEND,    "MLCOMMENTEND",    0);
+        set(NodeType::OPENBRACE,       "OPENBRACE",       BRACE);
+        set(NodeType::CLOSEBRACE,      "CLOSEBRACE",      BRACE);
+        set(NodeType::ASSUME,          "ASSUME",          0);
+        set(NodeType::USING,           "USING",           0);
+        set(NodeType::ATTRIB,          "ATTRIB",          0, 14);
+        set(NodeType::ENDOFSTREAM,     "ENDOFSTREAM",     0);
+        set(NodeType::CONDITION,       "CONDITION",       0);
+        set(NodeType::FSLASH,          "FSLASH",          0);
+        set(NodeType::BSLASH,          "BSLASH",          0);
+        set(NodeType::OPENCAR,         "OPENCAR",         0);
+        set(NodeType::CLOSECAR,        "CLOSECAR",        0);
+        set(NodeType::RETURN,          "RETURN",          START);
+        set(NodeType::RETFUNC,         "RETFUNC",         0);
+        set(NodeType::RETNAT,          "RETNAT",          0);
+        set(NodeType::RETTYPE,         "RETTYPE",         0);
+        set(NodeType::IF,              "IF",              START);
+        set(NodeType::ELSE,            "ELSE",            START);
+        set(NodeType::IFRESULTS,       "IFRESULTS",       0);
+        set(NodeType::TERNARY,         "TERNARY",         0);
+        set(NodeType::SWITCH,          "SWITCH",          0);
+        set(NodeType::CASE,            "CASE",            0);
+        set(NodeType::BITAND,          "BITAND",          BITWISE | MEMORY_CANDIDATE | PREFIX, 7, NodeType::FINDADDRESS);
+        set(NodeType::BITOR,           "BITOR",           BITWISE, 5);
+        set(NodeType::BITXOR,          "BITXOR",          BITWISE, 6);
+        set(NodeType::BITNEGATE,       "BITNEGATE",       0, 13, NodeType::BITNEGATE);
+        set(NodeType::NOT,             "NOT",             LOGIC | PREFIX, 13);
+        set(NodeType::ARITHRIGHTSHIFT, "ARITHRIGHTSHIFT", BITWISE, 10);
+        set(NodeType::ARITHLEFTSHIFT,  "ARITHLEFTSHIFT",  BITWISE, 10);
+        set(NodeType::LOGICRIGHTSHIFT, "LOGICRIGHTSHIFT", BITWISE, 10);
+        set(NodeType::LOGICAND,        "LOGICAND",        LOGIC, 4);
+        set(NodeType::LOGICOR,         "LOGICOR",         LOGIC, 3);
+        set(NodeType::LOGICXOR,        "LOGICXOR",        LOGIC);
+        set(NodeType::LOGICNEGATE,     "LOGICNEGATE",     0);
+        set(NodeType::SWITCHSIGN,      "SWITCHSIGN",      UNARY);
+        set(NodeType::NODE,            "NODE",            0);
+        set(NodeType::PRINT,           "PRINT",           0);
+        set(NodeType::SYSCALL,         "SYSCALL",         0);
+        set(NodeType::PTRDEREF,        "PTRDEREF",        UNARY | MEMORY);
+        set(NodeType::FINDADDRESS,     "FINDADDRESS",     UNARY | MEMORY);
+        set(NodeType::INC,             "INC",             0);
+        set(NodeType::DEC,             "DEC",             0);
+        set(NodeType::PROGRAM,         "PROGRAM",         0);
+        set(NodeType::FORWARD,         "FORWARD",         0);
+        set(NodeType::INVALID,         "INVALID",         0);
+        set(NodeType::MEMBER,          "MEMBER",          0);
+        set(NodeType::FUNCTION,        "FUNCTION",        START);
+        set(NodeType::FUNCTIONAPP,     "FUNCTIONAPP",     0);
+        set(NodeType::ARGUMENT,        "ARGUMENT",        0);
+        set(NodeType::FUNCTIONRETURN,  "FUNCTIONRETURN",  0);
+        set(NodeType::BLOCKSTART,      "BLOCKSTART",      0);
+        set(NodeType::BLOCKEND,        "BLOCKEND",        0);
+        set(NodeType::FUNCTIONNAME,    "FUNCTIONNAME",    0);
+        set(NodeType::FUNCTIONPARAM,   "FUNCTIONPARAM",   0);
+        set(NodeType::FUNCTIONLINE,    "FUNCTIONLINE",    0);
+        set(NodeType::FUNCTIONCALL,    "FUNCTIONCALL",    0);
+        set(NodeType::FUNCTIONBODY,    "FUNCTIONBODY",    0);
+        set(NodeType::DIRECTIVE,       "DIRECTIVE",       0);
+        set(NodeType::DIRTYPE,         "DIRTYPE",         0);
+        set(NodeType::DIRVALUE,        "DIRVALUE",        0);
+        set(NodeType::DIRIMPORT,       "DIRIMPORT",       0);
+        set(NodeType::DIRLIBDEF,       "DIRLIBDEF",       0);
+        set(NodeType::DIRPRIVATE,      "DIRPRIVATE",      0);
+        set(NodeType::DIRALIAS,        "DIRALIAS",        0);
+        set(NodeType::DIRUSERTYPE,     "DIRUSERTYPE",     0);
+
+        return table;
+    }
 
-    inline const std::unordered_set<NodeType> MEMORY_SYMBOLS = {
-        NodeType::FINDADDRESS, NodeType::PTRDEREF, NodeType::VARIABLE
-    };
+    inline constexpr std::array<NodeTraits, NODETYPE_COUNT> NODE_TRAITS = buildTraitTable();
 
-    inline const std::unordered_set<NodeType> ARITH_SYMBOLS = {
-        NodeType::ADD, NodeType::SUB, NodeType::MUL,
-        NodeType::DIV, NodeType::MODULO
-    };
+    constexpr bool allTraitsNamed() {
+        for(const auto& row : NODE_TRAITS) {
+            if(!row.name) return false;
+        }
+        return true;
+    }
 
-    inline const std::unordered_set<NodeType> BITWISE_SYMBOLS = {
-        NodeType::BITAND, NodeType::BITOR, NodeType::BITXOR,
-        NodeType::ARITHLEFTSHIFT, NodeType::ARITHRIGHTSHIFT,
-        NodeType::LOGICRIGHTSHIFT
-    };
+    static_assert(allTraitsNamed(), "Every NodeType needs a row in buildTraitTable()");
 
-    inline const std::unordered_set<NodeType> LOGIC_SYMBOLS = {
-        NodeType::LOGICAND, NodeType::LOGICOR, NodeType::LOGICXOR,
-        NodeType::LT, NodeType::LTE, NodeType::GT,
-        NodeType::GTE, NodeType::EQ, NodeType::NEQ,
-        NodeType::NOT
-    };
+    constexpr const NodeTraits& traitsOf(NodeType type) {
+        return NODE_TRAITS[static_cast<size_t>(type)];
+    }
 
-    inline const std::unordered_set<NodeType> MEMORY_CANDIDATE_SYMBOLS = {
-        NodeType::MUL, NodeType::BITAND
-    };
+    constexpr bool hasTrait(NodeType type, uint16_t flags) {
+        return traitsOf(type).flags & flags;
+    }
 
-    inline const std::unordered_set<NodeType> PREFIX_OPERATORS = {
-        NodeType::MUL, NodeType::BITAND, NodeType::SUB, NodeType::NOT
-    };
+    constexpr bool isArithmetic(NodeType type) {
+        return hasTrait(type, trait::ARITH);
+    }
 
-    inline bool isArithmetic(NodeType type) {
-        return ARITH_SYMBOLS.count(type);
+    constexpr bool isLogical(NodeType type) {
+        return hasTrait(type, trait::LOGIC);
     }
 
-    inline bool isLogical(NodeType type) {
-        return LOGIC_SYMBOLS.count(type);
+    constexpr bool isBitwise(NodeType type) {
+        return hasTrait(type, trait::BITWISE);
     }
 
-    inline bool isLiteral(NodeType type) {
-        return LITERAL_SYMBOLS.count(type);
+    constexpr bool isLiteral(NodeType type) {
+        return hasTrait(type, trait::LITERAL);
     }
-    
-    inline bool isOperator(NodeType type) {
-        return isArithmetic(type) || isLogical(type) || BITWISE_SYMBOLS.count(type);
+
+    constexpr bool isTypeSymbol(NodeType type) {
+        return hasTrait(type, trait::TYPE);
     }
 
-    inline bool isPrefixOperator(NodeType type) {
-        return PREFIX_OPERATORS.count(type);
+    constexpr bool isStartSymbol(NodeType type) {
+        return hasTrait(type, trait::START);
     }
 
-    inline NodeType mapUnaryOperator(NodeType type) {
-        NodeType mapped;
+    constexpr bool isBrace(NodeType type) {
+        return hasTrait(type, trait::BRACE);
+    }
 
-        switch(type) {
-            case NodeType::MUL: 
-                mapped = NodeType::PTRDEREF;
-                break;
-            case NodeType::BITAND:
-                mapped = NodeType::FINDADDRESS;
-                break;
-            case NodeType::SUB:
-                mapped = NodeType::SWITCHSIGN;
-                break;
-            case NodeType::BITNEGATE:
-                mapped = NodeType::BITNEGATE;
-                break;
-            default:
-                mapped = NodeType::INVALID;
-                break;
-        }
+    constexpr bool isUnary(NodeType type) {
+        return hasTrait(type, trait::UNARY);
+    }
 
-        return mapped;
+    constexpr bool isMemory(NodeType type) {
+        return hasTrait(type, trait::MEMORY);
     }
 
+    constexpr bool isMemoryCandidate(NodeType type) {
+        return hasTrait(type, trait::MEMORY_CANDIDATE);
+    }
+    
+    constexpr bool isOperator(NodeType type) {
+        return hasTrait(type, trait::OPERATOR);
+    }
 
+    constexpr bool isPrefixOperator(NodeType type) {
+        return hasTrait(type, trait::PREFIX);
+    }
 
+    constexpr NodeType mapUnaryOperator(NodeType type) {
+        return traitsOf(type).unary;
+    }
 
-// Not sure this is optimal
-inline std::string nodeTypeToString(NodeType t) {
-    switch (t) {
-        case NodeType::VARDEF: return "VARDEF";
-        case NodeType::VARIABLE: return "VARIABLE";
-        case NodeType::REDEF: return "REDEF";
-        case NodeType::ASSIGN: return "ASSIGN";
-        case NodeType::GLOBALVARDEF: return "GLOBALVARDEF";
-        case NodeType::ADD: return "ADD";
-        case NodeType::SUB: return "SUB";
-        case NodeType::MUL: return "MUL";
-        case NodeType::DIV: return "DIV";
-        case NodeType::LT: return "LT";
-        case NodeType::GT: return "GT";
-        case NodeType::GTE: return "GTE";
-        case NodeType::LTE: return "LTE";
-        case NodeType::EQ: return "EQ";
-        case NodeType::NEQ: return "NEQ";
-        case NodeType::MODULO: return "MODULO";
-        case NodeType::LOOPDEF: return "LOOPDEF";
-        case NodeType::LOOPCOND: return "LOOPCOND";
-        case NodeType::FORLOOP: return "FORLOOP";
-        case NodeType::WHILELOOP: return "WHILELOOP";
-        case NodeType::LOOPITERATION: return "LOOPITERATION";
-        case NodeType::INT32: return "INT32";
-        case NodeType::INT64: return "INT64";
-        case NodeType::FP32: return "FP32";
-        case NodeType::FP64: return "FP64";
-        case NodeType::STR: return "STR";
-        case NodeType::CHAR: return "CHAR";
-        case NodeType::BOOL_TR: return "BOOL_TR";
-        case NodeType::UNIFIED: return "UNIFIED";
-        case NodeType::SINGULAR: return "SINGULAR";
-        case NodeType::TYPE: return "TYPE";
-        case NodeType::VOID: return "VOID";
-        case NodeType::BOOL_FA: return "BOOL_FA";
-        case NodeType::NUM32: return "NUM32";
-        case NodeType::NUM64: return "NUM64";
-        case NodeType::NUMBER: return "NUMBER";
-        case NodeType::ARRAY_TYPE: return "ARRAY_TYPE";
-        case NodeType::MAP: return "MAP";
-        case NodeType::FUNCTIONCHAIN: return "FUNCTIONCHAIN";
-        case NodeType::UNSIGNED: return "UNSIGNED";
-        case NodeType::STRUCT: return "STRUCT";
-        case NodeType::BOOL: return "BOOL";
-        case NodeType::SHORT: return "SHORT";
-        case NodeType::RAWBIN: return "RAWBIN";
-        case NodeType::RAWHEX: return "RAWHEX";
-        case NodeType::ARRAY_SIZE: return "ARRAY_SIZE";
-        case NodeType::ARRAY: return "ARRAY";
-        case NodeType::ARRAY_ACCESS: return "ARRAY_ACCESS";
-        case NodeType::ARRAY_INDEX: return "ARRAY_INDEX";
-        case NodeType::FINAL: return "FINAL";
-        case NodeType::STATIC: return "STATIC";
-        case NodeType::PUBLIC: return "PUBLIC";
-        case NodeType::PRIVATE: return "PRIVATE";
-        case NodeType::IMPLICIT: return "IMPLICIT";
-        case NodeType::CONSTANT: return "CONSTANT";
-        case NodeType::NATIVE: return "NATIVE";
-        case NodeType::FUNCTION_T: return "FUNCTION_T";
-        case NodeType::INT32_T: return "INT32_T";
-        case NodeType::INT64_T: return "INT64_T";
-        case NodeType::FP32_T: return "FP32_T";
-        case NodeType::FP64_T: return "FP64_T";
-        case NodeType::STRING_T: return "STRING_T";
-        case NodeType::CHAR_T: return "CHAR_T";
-        case NodeType::BOOL_T: return "BOOL_T";
-        case NodeType::STR_T: return "STR_T";
-        case NodeType::TYPE_T: return "TYPE_T";
-        case NodeType::PTR_TYPE: return "PTR_T";
-        case NodeType::USERTYPE_T: return "USERTYPE_T";
-        case NodeType::CAST: return "CAST";
-        case NodeType::VOID_T: return "VOID_T";
-        case NodeType::STAR: return "STAR";
-        case NodeType::FUNCTION_STAR: return "FUNCTION_STAR";
-        case NodeType::INT32_STAR: return "INT32_STAR";
-        case NodeType::INT64_STAR: return "INT64_STAR";
-        case NodeType::FP32_STAR: return "FP32_STAR";
-        case NodeType::FP64_STAR: return "FP64_STAR";
-        case NodeType::UNIFIED_STAR: return "UNIFIED_STAR";
-        case NodeType::STRING_STAR: return "STRING_STAR";
-        case NodeType::CHAR_STAR: return "CHAR_STAR";
-        case NodeType::BOOL_STAR: return "BOOL_STAR";
-        case NodeType::STR_STAR: return "STR_STAR";
-        case NodeType::TYPE_STAR: return "TYPE_STAR";
-        case NodeType::USERTYPE_STAR: return "USERTYPE_STAR";
-        case NodeType::CAST_STAR: return "CAST_STAR";
-        case NodeType::VOID_STAR: return "VOID_STAR";
-        case NodeType::STRUCT_STAR: return "STRUCT_STAR";
-        case NodeType::OPENPARENS: return "OPENPARENS";
-        case NodeType::CLOSEPARENS: return "CLOSEPARENS";
-        case NodeType::OPENBRKT: return "OPENBRKT";
-        case NodeType::CLOSEBRKT: return "CLOSEBRKT";
-        case NodeType::ENDOFLINE: return "ENDOFLINE";
-        case NodeType::COMMADELIMIT: return "COMMADELIMIT";
-        case NodeType::SQUOTE: return "SQUOTE";
-        case NodeType::DQUOTE: return "DQUOTE";
-        case NodeType::COMMENT: return "COMMENT";
-        case NodeType::MLCOMMENTSTART: return "MLCOMMENTSTART";
-        case NodeType::MLCOMMENTEND: return "MLCOMMENTEND";
-        case NodeType::OPENBRACE: return "OPENBRACE";
-        case NodeType::CLOSEBRACE: return "CLOSEBRACE";
-        case NodeType::ASSUME: return "ASSUME";
-        case NodeType::USING: return "USING";
-        case NodeType::ATTRIB: return "ATTRIB";
-        case NodeType::ENDOFSTREAM: return "ENDOFSTREAM";
-        case NodeType::CONDITION: return "CONDITION";
-        case NodeType::FSLASH: return "FSLASH";
-        case NodeType::BSLASH: return "BSLASH";
-        case NodeType::RETURN: return "RETURN";
-        case NodeType::RETFUNC: return "RETFUNC";
-        case NodeType::RETNAT: return "RETNAT";
-        case NodeType::RETTYPE: return "RETTYPE";
-        case NodeType::IF: return "IF";
-        case NodeType::ELSE: return "ELSE";
-        case NodeType::IFRESULTS: return "IFRESULTS";
-        case NodeType::TERNARY: return "TERNARY";
-        case NodeType::SWITCH: return "SWITCH";
-        case NodeType::CASE: return "CASE";
-        case NodeType::BITAND: return "BITAND";
-        case NodeType::BITOR: return "BITOR";
-        case NodeType::BITXOR: return "BITXOR";
-        case NodeType::BITNEGATE: return "BITNEGATE";
-        case NodeType::NOT: return "NOT";
-        case NodeType::ARITHRIGHTSHIFT: return "ARITHRIGHTSHIFT";
-        case NodeType::ARITHLEFTSHIFT: return "ARITHLEFTSHIFT";
-        case NodeType::LOGICRIGHTSHIFT: return "LOGICRIGHTSHIFT";
-        case NodeType::LOGICAND: return "LOGICAND";
-        case NodeType::LOGICOR: return "LOGICOR";
-        case NodeType::LOGICXOR: return "LOGICXOR";
-        case NodeType::LOGICNEGATE: return "LOGICNEGATE";
-        case NodeType::SWITCHSIGN: return "SWITCHSIGN";
-        case NodeType::NODE: return "NODE";
-        case NodeType::PRINT: return "PRINT";
-        case NodeType::SYSCALL: return "SYSCALL";
-        case NodeType::PTRDEREF: return "PTRDEREF";
-        case NodeType::FINDADDRESS: return "FINDADDRESS";
-        case NodeType::INC: return "INC";
-        case NodeType::DEC: return "DEC";
-        case NodeType::PROGRAM: return "PROGRAM";
-        case NodeType::FORWARD: return "FORWARD";
-        case NodeType::INVALID: return "INVALID";
-        case NodeType::MEMBER: return "MEMBER";
-        case NodeType::FUNCTION: return "FUNCTION";
-        case NodeType::FUNCTIONAPP: return "FUNCTIONAPP";
-        case NodeType::ARGUMENT: return "ARGUMENT";
-        case NodeType::FUNCTIONRETURN: return "FUNCTIONRETURN";
-        case NodeType::BLOCKSTART: return "BLOCKSTART";
-        case NodeType::BLOCKEND: return "BLOCKEND";
-        case NodeType::FUNCTIONNAME: return "FUNCTIONNAME";
-        case NodeType::FUNCTIONPARAM: return "FUNCTIONPARAM";
-        case NodeType::FUNCTIONLINE: return "FUNCTIONLINE";
-        case NodeType::FUNCTIONCALL: return "FUNCTIONCALL";
-        case NodeType::FUNCTIONBODY: return "FUNCTIONBODY";
-        case NodeType::DIRECTIVE: return "DIRECTIVE";
-        case NodeType::DIRTYPE: return "DIRTYPE";
-        case NodeType::DIRVALUE: return "DIRVALUE";
-        case NodeType::DIRIMPORT: return "DIRIMPORT";
-        case NodeType::DIRLIBDEF: return "DIRLIBDEF";
-        case NodeType::DIRPRIVATE: return "DIRPRIVATE";
-        case NodeType::DIRALIAS: return "DIRALIAS";
-        case NodeType::DIRUSERTYPE: return "DIRUSERTYPE";
-        case NodeType::MODULE: return "MODULE";
-        default: return "UNKNOWN_NODETYPE";
+    inline std::string nodeTypeToString(NodeType t) {
+        if(static_cast<size_t>(t) >= NODETYPE_COUNT) return "UNKNOWN_NODETYPE";
+        return traitsOf(t).name;
     }
-}
 
     /*
         Convert raw ptr to string based on dtype
@@ -323,44 +338,36 @@ inline std::string nodeTypeToString(NodeType t) {
     }
 
 
-    inline int operatorPrecedence(NodeType op) {
-        switch(op) {
-            case NodeType::LOGICOR:     return 3;
-            case NodeType::LOGICAND:    return 4;
-            case NodeType::BITOR:       return 5;
-            case NodeType::BITXOR:      return 6;
-            case NodeType::BITAND:      return 7;
-
-            case NodeType::EQ:
-            case NodeType::NEQ:
-                return 8;
-
-            case NodeType::LT:
-            case NodeType::LTE:
-            case NodeType::GT:
-            case NodeType::GTE:
-                return 9;
-
-            case NodeType::ARITHLEFTSHIFT:
-            case NodeType::ARITHRIGHTSHIFT:
-            case NodeType::LOGICRIGHTSHIFT:
-                return 10;
-            
-            case NodeType::ADD:
-            case NodeType::SUB:
-                return 11;
-
-            case NodeType::MUL:
-            case NodeType::DIV:
-            case NodeType::MODULO:
-                return 12;
-
-            case NodeType::BITNEGATE:
-            case NodeType::NOT:
-                return 13;
-
-            case NodeType::ATTRIB:      return 14;
-            default:                    return 0;
+    constexpr int operatorPrecedence(NodeType op) {
+        return traitsOf(op).precedence;
+    }
+
+    // Numeric promotion order, shared by the emitter and the AST passes
+    constexpr int numericRank(NodeType type) {
+        switch(type) {
+            case NodeType::CHAR:    return -1;
+            case NodeType::SHORT:   return 0;
+            case NodeType::INT32:   return 1;
+            case NodeType::INT64:   return 2;
+            case NodeType::FP32:    return 3;
+            case NodeType::FP64:    return 4;
+            default:                return -10;
+        }
+    }
+
+    constexpr NodeType promoteNumeric(NodeType t1, NodeType t2) {
+        if(numericRank(t1) > numericRank(t2)) return t1;
+        else return t2;
+    }
+
+    // Declared type (int32, fp64, ...) to the literal type values of it carry
+    constexpr NodeType declaredToLiteral(NodeType type) {
+        switch(type) {
+            case NodeType::INT32_T: return NodeType::INT32;
+            case NodeType::INT64_T: return NodeType::INT64;
+            case NodeType::FP32_T:  return NodeType::FP32;
+            case NodeType::FP64_T:  return NodeType::FP64;
+            default:                return NodeType::INVALID;
         }
     }
 
@@ -4,36 +4,45 @@
 
 namespace nvyc {
 
-    inline static int checkpoint_ = 0;
-    inline static bool DEBUG_MODE = false;
-
-    inline static unsigned int DEBUG_FLAG = 0;
     static constexpr int DEBUG_GEN         = 1 << 0;
     static constexpr int DEBUG_LEX         = 1 << 1;
     static constexpr int DEBUG_PARSE       = 1 << 2;
     static constexpr int DEBUG_EMISSION    = 1 << 3;
 
-    inline void enable_debugging(unsigned int flag) {
-        DEBUG_MODE = true;
-        DEBUG_FLAG = flag;
-    }
-
-    inline void disable_debugging() {
-        DEBUG_MODE = false;
-        DEBUG_FLAG = 0;
-    }
-
-    template <typename T>
-    inline void debug(const T& msg) {
-        if(DEBUG_MODE) std::cout << "Debug Message: " << msg << std::endl;
-    }
-
-    inline void checkpoint() {
-        if(DEBUG_MODE) std::cout << "Checkpoint " << checkpoint_++ << std::endl;
-    }
-
-    inline void reset() {
-        checkpoint_ = 0;
-    }
+    // Owned by a CompilationContext so concurrent compilations don't share counters
+    class DebugState {
+        private:
+            int checkpoint_ = 0;
+            bool debugMode = false;
+            unsigned int debugFlag = 0;
+
+        public:
+            void enable(unsigned int flag) {
+                debugMode = true;
+                debugFlag = flag;
+            }
+
+            void disable() {
+                debugMode = false;
+                debugFlag = 0;
+            }
+
+            bool enabled(unsigned int flag = 0) const {
+                return debugMode && (flag == 0 || (debugFlag & flag));
+            }
+
+            template <typename T>
+            void debug(const T& msg) {
+                if(debugMode) std::cout << "Debug Message: " << msg << std::endl;
+            }
+
+            void checkpoint() {
+                if(debugMode) std::cout << "Checkpoint " << checkpoint_++ << std::endl;
+            }
+
+            void reset() {
+                checkpoint_ = 0;
+            }
+    };
 
 }
@@ -1,10 +1,17 @@
 #include "LLVMEmission.hpp"
 #include "utils/EmissionBuilder.hpp"
+#include "generation/LexerStream.hpp"
+#include "generation/Parser.hpp"
+#include "passes/PassManager.hpp"
+#include "utils/ParserUtils.hpp"
 #include "error/Error.hpp"
 #include <unordered_map>
+#include <algorithm>
 #include <cstdint>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/Instructions.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/TimeProfiler.h>
 
 using CastType = nvyc::EmissionBuilder::CastType;
 using NumericType = nvyc::EmissionBuilder::NumericType;
@@ -28,6 +35,11 @@ namespace nvyc {
     void compileNode(EmissionBuilder* mod, const NASTNode* node) {
         NodeType type = node->getType();
         switch(type) {
+            case NodeType::MODULE:
+                for(const auto& subnode : node->getSubnodes()) {
+                    if(subnode) compileNode(mod, subnode.get());
+                }
+                break;
             case NodeType::FUNCTION:
                 compileFunction(mod, node);
                 break;
@@ -45,15 +57,113 @@ namespace nvyc {
 
 
     void compile(EmissionBuilder* mod, const std::vector<std::unique_ptr<NASTNode>>& nodes) {
+        CompileStats& stats = mod->getContext().getStats();
+
+        MemoryStats::Sample before = MemoryStats::threadSample();
+        {
+            auto scope = stats.time("emit");
+            for(auto& node : nodes) {
+                compileNode(mod, node.get());
+            }
+        }
 
-        for(auto& node : nodes) {
-            compileNode(mod, node.get());
+        if(stats.memoryEnabled()) {
+            // The module has no size query of its own, so it is charged whatever emission kept alive
+            MemoryUsage symbols = mod->getSymbols().memoryUsage();
+            MemoryStats::Sample emitted = MemoryStats::threadSample() - before;
+            MemoryUsage module;
+            module.bytes = std::max<int64_t>(emitted.liveBytes - (int64_t) symbols.bytes, 0);
+            module.allocations = emitted.allocations - std::min(emitted.allocations, symbols.allocations);
+            stats.addStructure("SymbolStorage maps", symbols);
+            stats.addStructure("LLVM module", module);
         }
 
+        recordModuleCounters(mod);
+
         //mod->getModule()->print(llvm::outs(), nullptr);
     }
 
 
+    /*
+        Streaming compile: each declaration is parsed, run through the
+        per-declaration passes, emitted and (above -O0) optimized on its own,
+        then its AST is dropped before the next one is read. Together with
+        LexerStream this keeps front-end memory bounded by the largest
+        declaration; only the LLVM module grows with the input.
+        -fprofile-generate instrumentation is a module pass, so it only
+        applies to the whole-module optimize(), not here.
+    */
+    void compileStream(EmissionBuilder* mod, LexerStream& source, Passes::PassManager& passes, OptLevel level) {
+        CompileStats& stats = mod->getContext().getStats();
+        Parser parser(mod->getContext());
+
+        while(std::unique_ptr<NodeStream> declaration = source.next()) {
+            std::vector<std::unique_ptr<NASTNode>> nodes = parser.parseStream(*declaration);
+            declaration.reset();
+
+            for(auto& node : nodes) {
+                node = passes.executeDeclarationPasses(std::move(node));
+                if(!node) continue;
+
+                {
+                    auto scope = stats.time("emit");
+                    compileNode(mod, node.get());
+                }
+
+                optimizeDeclaration(mod, node.get(), level);
+                node.reset();
+            }
+        }
+
+        recordModuleCounters(mod);
+    }
+
+    /*
+        Every body a declaration emitted: the function, or each function of a
+        module. A multiversioned function's name is an ifunc by now, its
+        bodies are name.default and one name.<feature> clone per feature.
+    */
+    void optimizeDeclaration(EmissionBuilder* mod, const NASTNode* node, OptLevel level) {
+        if(node->getType() == NodeType::MODULE) {
+            for(const auto& subnode : node->getSubnodes()) {
+                if(subnode) optimizeDeclaration(mod, subnode.get(), level);
+            }
+            return;
+        }
+        if(node->getType() != NodeType::FUNCTION) return;
+
+        llvm::Module* module = mod->getModule();
+        std::string name = node->getData().asString();
+        std::vector<std::string> versions = ParserUtils::getFunctionAttribute(*node, "multiversion");
+        if(versions.empty()) {
+            mod->optimizeFunction(module->getFunction(name), level);
+            return;
+        }
+        for(const std::string& version : versions) {
+            mod->optimizeFunction(module->getFunction(name + "." + version), level);
+        }
+    }
+
+    void recordModuleCounters(EmissionBuilder* mod) {
+        CompileStats& stats = mod->getContext().getStats();
+        if(!stats.countersEnabled()) return;
+
+        uint64_t functions = 0, instructions = 0, allocas = 0;
+        for(const llvm::Function& func : *mod->getModule()) {
+            if(!func.isDeclaration()) functions++;
+            for(const llvm::BasicBlock& block : func) {
+                for(const llvm::Instruction& inst : block) {
+                    instructions++;
+                    if(llvm::isa<llvm::AllocaInst>(inst)) allocas++;
+                }
+            }
+        }
+        stats.addCounter("functions", functions);
+        stats.addCounter("ir instructions", instructions);
+        stats.addCounter("allocas", allocas);
+    }
+
+
     void compileNative(EmissionBuilder* mod, const NASTNode* node) {
         const NASTNode* fNode = node->getSubnode(0);
         std::string funcName = fNode->getData().asString();
@@ -79,6 +189,7 @@ namespace nvyc {
 
     void compileFunction(EmissionBuilder* mod, const NASTNode* node) {
         std::string funcName = node->getData().asString();
+        llvm::TimeTraceScope trace("compileFunction", funcName);
         NodeType funcRType = node->getSubnode(1)->getSubnode(0)->getType();
         int rv = node->getSubnode(2)->getSubnode(0)->getSubnode(0)->getData().i32;
 
@@ -96,14 +207,34 @@ namespace nvyc {
             names.push_back(vNode->getData().asString());
         }
 
-        auto Func = mod->makeFunction(funcName, names, args, funcRType, variadic);
+        bool exported = mod->getContext().getExportedFunctions().contains(funcName);
+        auto Func = mod->makeFunction(funcName, names, args, funcRType, variadic, exported);
         auto block = mod->createBlock(Func, "entry");
         mod->setInsertionPoint(block);
 
+        // Parameters and locals live in the function's scope and are gone once it is emitted
+        mod->getSymbols().pushScope();
+        mod->getSymbols().clearEscaping();
+        findAddressTaken(mod, node->getSubnode(2));
+
+        // Parameters are bound like any other local
+        int argIdx = 0;
+        for(auto& arg : Func->args()) {
+            NodeType argType = symbols::declaredToLiteral(variables->getSubnode(argIdx++)->getType());
+            ResultType argResult = {argType, arg.getType()};
+            mod->defineVariable(arg.getName().str(), argResult, &arg);
+        }
+
         const std::vector<std::unique_ptr<NASTNode>>& bodyNodes = node->getSubnode(2)->getSubnodes();
         for(auto& bodyNode : bodyNodes) {
             compileNode(mod, bodyNode.get());
         }
+
+        // Cloned only once the body is complete
+        std::vector<std::string> versions = ParserUtils::getFunctionAttribute(*node, "multiversion");
+        if(!versions.empty()) mod->multiversionFunction(Func, versions);
+
+        mod->getSymbols().popScope();
     }
 
 
@@ -133,7 +264,7 @@ namespace nvyc {
             case NodeType::VARIABLE: {
                 std::string var = v.str;
                 NodeType otherType = mod->getSymbols().getVarNvyType(var);
-                val = mod->getBuilder().CreateLoad(mod->getNativeType(otherType), mod->getSymbols().getAlloca(var), var + "_val");
+                val = mod->loadVariable(var, mod->getNativeType(otherType));
                 break;
             }
             default: {
@@ -163,61 +294,74 @@ namespace nvyc {
 
         ResultType resultType;
         llvm::Value* val = compileExpression(mod, varValue, 0, &resultType);
-        llvm::Value* var = mod->createVariable(name, resultType);
+        mod->defineVariable(name, resultType, val);
+    }
 
-        mod->storeToVariable(var, val);
+    // Marks every variable under '&'/ref so it gets an alloca, the rest stay in SSA form
+    void findAddressTaken(EmissionBuilder* mod, const NASTNode* node) {
+        if(node->getType() == NodeType::FINDADDRESS) {
+            // Bare 'ref' with no operand attached, can't tell what escapes
+            if(node->getSubnodes().empty()) {
+                mod->getSymbols().markAllEscaping();
+                return;
+            }
+
+            const NASTNode* target = node->getSubnode(0);
+            if(target->getType() == NodeType::VARIABLE) {
+                mod->getSymbols().markEscaping(target->getData().asString());
+            }
+        }
+
+        for(const auto& subnode : node->getSubnodes()) {
+            if(subnode) findAddressTaken(mod, subnode.get());
+        }
     }
 
     llvm::Value* compileExpression(EmissionBuilder* mod, const NASTNode* node, int exprType, ResultType* result) {
         NodeType nodeType = node->getType();
 
-        bool isArith = symbols::ARITH_SYMBOLS.count(nodeType);
-        bool isLogic = symbols::LOGIC_SYMBOLS.count(nodeType);
+        bool isArith = symbols::isArithmetic(nodeType);
+        bool isLogic = symbols::isLogical(nodeType);
 
-        if(symbols::LITERAL_SYMBOLS.count(nodeType)) {
-            mod->populateType(result, nodeType, mod->getNativeType(nodeType));
+        if(symbols::isLiteral(nodeType)) {
+            mod->populateType(result, nodeType, mod->resolvedNativeType(node));
             return getValue(mod, nodeType, node->getData());
         }
 
         // Load variable
         else if(nodeType == NodeType::VARIABLE) {
-            const std::string varName = node->getData().str;
-            llvm::Type* varType = mod->getSymbols().getVarNativeType(varName);
-            nodeType = mod->getSymbols().getVarNvyType(varName);
-            mod->populateType(result, nodeType, mod->getNativeType(nodeType));
-            return mod->getBuilder().CreateLoad(varType, mod->getSymbols().getAlloca(varName));
+            nodeType = mod->resolvedType(node);
+            llvm::Type* varType = mod->resolvedNativeType(node);
+            mod->populateType(result, nodeType, varType);
+            return mod->loadVariable(mod->symbolOf(node), varType);
         }
 
         // Arithmetic & Logical ops
         else if(isArith || isLogic) {
             NodeType op = nodeType;
-            NodeType resultType = mod->arithmeticPrecedence(node);
+            NodeType resultType = mod->resolvedType(node);
 
             // In order of LHS, RHS
             llvm::Value* values[2];
             const NASTNode* operands[2] = {node->getSubnode(0), node->getSubnode(1)};
             NodeType types[2] = {operands[0]->getType(), operands[1]->getType()};
-            std::string variableNames[2] = {operands[0]->getData().str, operands[1]->getData().str};
 
             for(int i = 0; i < 2; i++) {
                 types[i] = operands[i]->getType();
                 NodeType sideType = types[i];
-                const std::string sideVariable = variableNames[i];
-                llvm::Value* sideValue;
 
                 if(sideType == NodeType::VARIABLE) {
-                    sideValue = mod->getSymbols().getAlloca(sideVariable);
-                    sideType = mod->getSymbols().getVarNvyType(sideVariable);
-                    types[i] = sideType;
-                    values[i] = mod->getBuilder().CreateLoad(mod->getNativeType(sideType), sideValue);
+                    types[i] = mod->resolvedType(operands[i]);
+                    values[i] = mod->loadVariable(mod->symbolOf(operands[i]), mod->resolvedNativeType(operands[i]));
                 }
                 
-                else if(symbols::LITERAL_SYMBOLS.count(sideType)) {
+                else if(symbols::isLiteral(sideType)) {
                     values[i] = getValue(mod, sideType, operands[i]->getData());
                 }
 
                 else {
                     values[i] = compileExpression(mod, operands[i], exprType, nullptr);
+                    types[i] = mod->resolvedType(operands[i]);
                 }
 
                 // Logic for promotion/demotion
@@ -229,7 +373,7 @@ namespace nvyc {
             }
 
             NumericType mode = mod->getMode(resultType);
-            mod->populateType(result, resultType, mod->getNativeType(resultType));
+            mod->populateType(result, resultType, mod->resolvedNativeType(node));
 
             if(isArith)      return mod->createArithmeticOperation(op, mode, values[0], values[1]);
             else if(isLogic) return mod->createLogicalOperation(op, mode, values[0], values[1]);
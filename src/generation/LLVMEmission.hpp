@@ -7,14 +7,23 @@
 
 namespace nvyc {
 
+    class LexerStream;
+    namespace Passes {
+        class PassManager;
+    }
+
     static constexpr int EXPR_ARITH = 0;
     static constexpr int EXPR_LOGIC = 1;
 
     void compile(EmissionBuilder* mod, const std::vector<std::unique_ptr<NASTNode>>& nodes);
+    void compileStream(EmissionBuilder* mod, LexerStream& source, Passes::PassManager& passes, OptLevel level);
     void compileNode(EmissionBuilder* mod, const NASTNode* node);
+    void optimizeDeclaration(EmissionBuilder* mod, const NASTNode* node, OptLevel level);
+    void recordModuleCounters(EmissionBuilder* mod);
 
     void compileFunction(EmissionBuilder* mod, const NASTNode* node);
     void compileVardef(EmissionBuilder* mod, const NASTNode* node);
+    void findAddressTaken(EmissionBuilder* mod, const NASTNode* node);
     void compileNative(EmissionBuilder* mod, const NASTNode* node);
     llvm::Value* getValue(EmissionBuilder* mod, NodeType type, const Value v);
     void compileNative(std::unique_ptr<NASTNode> node);
@@ -28,13 +28,19 @@ const std::unordered_set<std::string> IDENTIFIERS = {
 
     "final", "static", "public", "private",
     "impl", "const", "native", "struct", "ref",
-    "module",
+    "module", "multiversion",
 
     "int32", "int64", "fp32", "fp64", "bool",
     "short", "char", "string", "void", "function",
     "func", "type", "unified", "ptr_t"
 };
 
+const size_t MAX_IDENTIFIER_LENGTH = [] {
+    size_t longest = 0;
+    for(const std::string& identifier : IDENTIFIERS) longest = std::max(longest, identifier.length());
+    return longest;
+}();
+
 const std::unordered_set<std::string> OPERATORS = {
     "+", "-", "/", "*", ".", "?",
     "&", "&&",
@@ -127,6 +133,9 @@ void nvyc::Lexer::init() {
     rep["struct"] = NodeType::STRUCT;
     rep["module"] = NodeType::MODULE,
 
+    // Function attributes, func f() -> int32 multiversion(avx2, default) { ... }
+    rep["multiversion"] = NodeType::DIRTYPE;
+
     // Delimiters
     rep["("] = NodeType::OPENPARENS;
     rep[")"] = NodeType::CLOSEPARENS;
@@ -218,140 +227,168 @@ NodeType nvyc::Lexer::numericNativeType(const std::string& s) const {
 }
 
 
-NodeStream* nvyc::Lexer::lex(const std::vector<std::string>& lines) {
-    NodeStream* head = new NodeStream();
-
-
-    // For debugging
-    int lineNumber = 1;
-
-    for(const std::string line: lines) {
-        int i = 0;
-        while(i < line.length()) {
-            char ch = line[i];
-            std::string currentToken;
+// The instance is shared between compilations, so the table must only be read after init()
+NodeType nvyc::Lexer::lookup(const std::string& token) const {
+    auto it = rep.find(token);
+    if(it != rep.end()) return it->second;
+    return NodeType::INVALID;
+}
 
-            /*
-            
-            
-            Use longest valid subtoken
-            
-            let x12 = 152;
-            - let (SPACE)
-            - x12 (SPACE)
-            - = (SPACE)
-            - 152 (SWITCH TOKEN TYPE)
-            - ; (EOL)
+// Appends the tokens of a single source line, shared by lex() and the streaming LexerStream
+void nvyc::Lexer::lexLine(const std::string& line, int lineNumber, NodeStream& out) {
+    int i = 0;
+    while(i < line.length()) {
+        char ch = line[i];
+        std::string currentToken;
 
+        /*
+        
+        
+        Use longest valid subtoken
+        
+        let x12 = 152;
+        - let (SPACE)
+        - x12 (SPACE)
+        - = (SPACE)
+        - 152 (SWITCH TOKEN TYPE)
+        - ; (EOL)
 
 
-            PROCESS:
 
-            do token identification and consumption
-            let x12 = 152;
+        PROCESS:
 
-            isalpha(let) { consume let } loop
-            isalpha(x) build until next valid token (=)) loop
-            isOperator(=) loop
-            isdigit(152) loop
+        do token identification and consumption
+        let x12 = 152;
 
+        isalpha(let) { consume let } loop
+        isalpha(x) build until next valid token (=)) loop
+        isOperator(=) loop
+        isdigit(152) loop
 
-            */
 
-            if(isspace(ch)) {
-                i++;
-            }
+        */
 
-            // Identifier / Keyword
-            else if(isalpha(ch)) {
-
-                int j = i;
-                char currentChar = line[j];
-                NodeType type;
-                std::string longestToken = "";
-
-                // Make sure token is not a delimiter or operator, and keep building
-                while(
-                    j < line.length() && 
-                    !isspace(currentChar) && 
-                    !DELIMITERS.count(currentChar) && 
-                    !OPERATORS.count(std::string(1, currentChar))
-                ) {
-                    currentToken += currentChar;
-                    j++;
-                    currentChar = line[j];
-                    
-                    if(IDENTIFIERS.count(currentToken)) {
-                        longestToken = currentToken;
-                    }
+        if(isspace(ch)) {
+            i++;
+        }
 
-                }
-                if(longestToken == "") {
-                    type = NodeType::VARIABLE;
+        // Identifier / Keyword
+        else if(isalpha(ch)) {
+
+            int j = i;
+            char currentChar = line[j];
+            NodeType type;
+            std::string longestToken = "";
+
+            // Make sure token is not a delimiter or operator, and keep building
+            while(
+                j < line.length() && 
+                !isspace(currentChar) && 
+                !DELIMITERS.count(currentChar) && 
+                !OPERATORS.count(std::string(1, currentChar))
+            ) {
+                currentToken += currentChar;
+                j++;
+                currentChar = line[j];
+                
+                // Past the longest keyword no prefix can match, don't rehash it per character
+                if(currentToken.length() <= MAX_IDENTIFIER_LENGTH && IDENTIFIERS.count(currentToken)) {
                     longestToken = currentToken;
-                }else{
-                    type = rep[longestToken];
                 }
 
-                head->addNode(type, Value(longestToken), lineNumber);
-                i += longestToken.length();
+            }
+            if(longestToken == "") {
+                type = NodeType::VARIABLE;
+                longestToken = currentToken;
+            }else{
+                type = lookup(longestToken);
             }
 
+            out.addNode(type, Value(longestToken), lineNumber);
+            i += longestToken.length();
+        }
 
-            // Delimiters are single character, so consume immediately
-            else if(DELIMITERS.count(ch)) {
-                head->addNode(rep[std::string(1, ch)], Value(std::string(1,ch)), lineNumber);
-                i++;
-            }
 
+        // Delimiters are single character, so consume immediately
+        else if(DELIMITERS.count(ch)) {
+            out.addNode(lookup(std::string(1, ch)), Value(std::string(1,ch)), lineNumber);
+            i++;
+        }
 
-            // Operators can be multiple characters, so loop until longest token is found
-            else if(OPERATORS.count(std::string(1, ch))) {
-                int j = i;
-                char currentChar = line[j];
-                NodeType type;
-                std::string longestToken = "";
 
-                // Only need to see if next token is an operator, since anything else will immediately consume
-                while(!isspace(currentChar) && OPERATORS.count(std::string(1, currentChar))) {
-                    longestToken += currentChar;
-                    j++;
-                    currentChar = line[j];
-                }
+        // Operators can be multiple characters, so loop until longest token is found
+        else if(OPERATORS.count(std::string(1, ch))) {
+            int j = i;
+            char currentChar = line[j];
+            NodeType type;
+            std::string longestToken = "";
 
-                head->addNode(rep[longestToken], Value(longestToken), lineNumber);
-                i += longestToken.length();
+            // Only need to see if next token is an operator, since anything else will immediately consume
+            while(!isspace(currentChar) && OPERATORS.count(std::string(1, currentChar))) {
+                longestToken += currentChar;
+                j++;
+                currentChar = line[j];
             }
-            
-
-            // Numbers
-            else if(isdigit(ch)) {
-                int j = i;
-                char currentChar = line[j];
-                std::string number;
-
-                while(isdigit(currentChar) || currentChar == '.' || NUMERIC_QUALIFIERS.count(currentChar)) {
-                    number += currentChar;
-                    j++;
-                    currentChar = line[j];
-                }
 
-                NodeType type = numericNativeType(number);
-                head->addNode(type, convertNumeric(type, number), lineNumber);
-                i += number.length();
-            }
-            
-            else{
-                nvyc::Error::nvyerr_out("Encountered unknown token type: ");
-                nvyc::Error::nvyerr_out(std::string(1, ch));
-                i++;
+            out.addNode(lookup(longestToken), Value(longestToken), lineNumber);
+            i += longestToken.length();
+        }
+        
+
+        // Numbers
+        else if(isdigit(ch)) {
+            int j = i;
+            char currentChar = line[j];
+            std::string number;
+
+            while(isdigit(currentChar) || currentChar == '.' || NUMERIC_QUALIFIERS.count(currentChar)) {
+                number += currentChar;
+                j++;
+                currentChar = line[j];
             }
 
-            // Reset token
-            currentToken = "";
+            NodeType type = numericNativeType(number);
+            out.addNode(type, convertNumeric(type, number), lineNumber);
+            i += number.length();
+        }
+        
+        else{
+            nvyc::Error::nvyerr_out("Encountered unknown token type: ");
+            nvyc::Error::nvyerr_out(std::string(1, ch));
+            i++;
         }
+
+        // Reset token
+        currentToken = "";
+    }
+}
+
+NodeStream* nvyc::Lexer::lex(CompilationContext& context, const std::vector<std::string>& lines) {
+    auto scope = context.getStats().time("lex");
+    NodeStream* head = new NodeStream();
+
+
+    // For debugging
+    int lineNumber = 1;
+
+    for(const std::string& line: lines) {
+        lexLine(line, lineNumber, *head);
         lineNumber++;
     }
+
+    context.getStats().addCounter("lines", lines.size());
+    context.getStats().addCounter("tokens", head->size());
+
+    if(context.getStats().memoryEnabled()) {
+        MemoryUsage tokenUsage, stringUsage;
+        head->memoryUsage(tokenUsage, stringUsage);
+        context.getStats().addStructure("NodeStream tokens", tokenUsage);
+        context.getStats().addStructure("Value strings (tokens)", stringUsage);
+    }
+
+    if(context.getDebug().enabled(DEBUG_LEX)) {
+        context.getDebug().debug("Lexed " + std::to_string(head->size()) + " tokens");
+    }
     return head;
 }
 
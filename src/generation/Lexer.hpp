@@ -3,6 +3,7 @@
 #include "data/NodeStream.hpp"
 #include "data/NodeType.hpp"
 #include "data/Value.hpp"
+#include "utils/CompilationContext.hpp"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -17,13 +18,15 @@ namespace nvyc {
             Lexer();
             void init();
             NodeType numericNativeType(const std::string& s) const;
+            NodeType lookup(const std::string& token) const;
             static const std::unordered_set<NodeType> NUMERICS;
         
         public:
             const Value NULL_VALUE = Value(NodeType::VOID);
             std::unordered_map<std::string, NodeType> rep;
             static Lexer& getInstance();
-            NodeStream* lex(const std::vector<std::string>& lines);
+            NodeStream* lex(CompilationContext& context, const std::vector<std::string>& lines);
+            void lexLine(const std::string& line, int lineNumber, NodeStream& out);
             Value convertNumeric(NodeType type, const std::string& value);
             bool isNumericLiteral(const std::string& s);
             
@@ -0,0 +1,130 @@
+#include "LexerStream.hpp"
+#include "Lexer.hpp"
+#include "error/Debug.hpp"
+#include <algorithm>
+
+namespace nvyc {
+
+    LexerStream::LexerStream(CompilationContext& ctx, const std::vector<std::string>& source, Passes::PassManager* pm,
+                             bool threaded, size_t ringCapacity)
+        : context(ctx), lines(source), passes(pm), threaded(threaded), ring(threaded ? ringCapacity : 1) {
+        if(threaded) producer = std::thread([this] { produce(); });
+    }
+
+    LexerStream::~LexerStream() {
+        ring.close();
+        if(producer.joinable()) producer.join();
+    }
+
+
+    // ----------------------------------------
+    //                PRODUCER
+    // ----------------------------------------
+
+    /*
+        Walks the pending tokens for the end of a top-level declaration: a ';'
+        or a closing '}' back at nesting 0, taking a trailing ';' along with the
+        brace (struct x { ... };). Returns the cut position or -1 if the
+        declaration continues past what has been lexed so far.
+    */
+    int LexerStream::findBoundary(bool atEnd) {
+        for(; scanned < (size_t) pending.size(); scanned++) {
+            NodeType type = pending.getType(scanned);
+
+            if(type == NodeType::OPENBRACE) nesting++;
+            else if(type == NodeType::CLOSEBRACE && nesting > 1) nesting--;
+            else if(type == NodeType::CLOSEBRACE) {
+                // Need the next token to know whether a ';' belongs to this brace
+                if(scanned + 1 >= (size_t) pending.size() && !atEnd) return -1;
+
+                nesting = 0;
+                bool trailing = scanned + 1 < (size_t) pending.size() && pending.getType(scanned + 1) == NodeType::ENDOFLINE;
+                return scanned + 1 + trailing;
+            }
+            else if(type == NodeType::ENDOFLINE && nesting == 0) {
+                return scanned + 1;
+            }
+        }
+        return -1;
+    }
+
+    std::unique_ptr<NodeStream> LexerStream::lexDeclaration() {
+        Lexer& lexer = Lexer::getInstance();
+
+        while(true) {
+            bool atEnd = nextLine >= lines.size();
+            int cut = findBoundary(atEnd);
+
+            // Whatever is left at the end of the file is the last declaration
+            if(cut < 0 && atEnd) cut = pending.size();
+
+            if(cut > 0) {
+                auto declaration = std::make_unique<NodeStream>();
+                pending.moveFront(cut, *declaration);
+                scanned = 0;
+
+                tokens += cut;
+                largestWindow = std::max<uint64_t>(largestWindow, cut);
+                return declaration;
+            }
+
+            if(atEnd) return nullptr;
+
+            lexer.lexLine(lines[nextLine], nextLine + 1, pending);
+            nextLine++;
+        }
+    }
+
+    // Producer thread, a nullptr marks the end of the input
+    void LexerStream::produce() {
+        while(true) {
+            std::unique_ptr<NodeStream> declaration = lexDeclaration();
+            bool last = !declaration;
+
+            // Fails only when the consumer is being destroyed
+            if(!ring.push(declaration) || last) return;
+        }
+    }
+
+
+    // ----------------------------------------
+    //                CONSUMER
+    // ----------------------------------------
+
+    std::unique_ptr<NodeStream> LexerStream::next() {
+        if(finished) return nullptr;
+
+        std::unique_ptr<NodeStream> declaration;
+        if(threaded) {
+            auto scope = context.getStats().time("lexWait");
+            ring.pop(declaration);
+        }
+        else {
+            auto scope = context.getStats().time("lex");
+            declaration = lexDeclaration();
+        }
+
+        if(!declaration) {
+            finish();
+            return nullptr;
+        }
+
+        if(passes) passes->executeLexicalPasses(*declaration);
+        return declaration;
+    }
+
+    // Producer state is only read once the thread is joined
+    void LexerStream::finish() {
+        finished = true;
+        if(producer.joinable()) producer.join();
+
+        context.getStats().addCounter("lines", lines.size());
+        context.getStats().addCounter("tokens", tokens);
+        context.getStats().addCounter("token window", largestWindow);
+
+        if(context.getDebug().enabled(DEBUG_LEX)) {
+            context.getDebug().debug("Streamed " + std::to_string(tokens) + " tokens, largest window " + std::to_string(largestWindow));
+        }
+    }
+
+} // namespace nvyc
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "data/NodeStream.hpp"
+#include "passes/PassManager.hpp"
+#include "utils/CompilationContext.hpp"
+#include "utils/SpscRing.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Streaming front end between the Lexer and the Parser. Instead of one
+        NodeStream for the whole file, tokens are handed out one top-level
+        declaration at a time (a function, struct, native, global or a whole
+        module block). Only the current line and the declaration being built
+        are held, so token memory is bounded by the largest declaration rather
+        than the file.
+
+        The window is a declaration rather than N tokens because the parser
+        scans bodies and calls to their matching delimiter and indexes the
+        stream absolutely, so its lookahead is the declaration itself.
+
+        With threaded set, lexing runs on a producer thread that feeds finished
+        declarations through an SPSC ring and overlaps with parsing. Lexical
+        passes and stats always run on the consumer, because CompilationContext
+        is single-threaded. lines must outlive the stream.
+    */
+    class LexerStream {
+        private:
+            CompilationContext& context;
+            const std::vector<std::string>& lines;
+            Passes::PassManager* passes;
+
+            // Producer side
+            size_t nextLine = 0;
+            NodeStream pending;     // Lexed tokens not yet cut into a declaration
+            size_t scanned = 0;     // Pending tokens already walked for nesting
+            int nesting = 0;
+            uint64_t tokens = 0;
+            uint64_t largestWindow = 0;
+
+            // Threaded mode
+            bool threaded;
+            SpscRing<std::unique_ptr<NodeStream>> ring;
+            std::thread producer;
+            bool finished = false;
+
+            int findBoundary(bool atEnd);
+            std::unique_ptr<NodeStream> lexDeclaration();
+            void produce();
+            void finish();
+
+        public:
+            static constexpr size_t DEFAULT_RING_CAPACITY = 64;
+
+            LexerStream(CompilationContext& ctx, const std::vector<std::string>& source, Passes::PassManager* pm = nullptr,
+                        bool threaded = false, size_t ringCapacity = DEFAULT_RING_CAPACITY);
+            ~LexerStream();
+
+            LexerStream(const LexerStream&) = delete;
+            LexerStream& operator=(const LexerStream&) = delete;
+
+            // Next declaration's tokens, already through the lexical passes. nullptr once the input is exhausted
+            std::unique_ptr<NodeStream> next();
+    };
+
+} // namespace nvyc
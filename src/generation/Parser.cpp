@@ -1,11 +1,15 @@
 #include "Parser.hpp"
+#include "LexerStream.hpp"
 #include "utils/ParserUtils.hpp"
 #include "data/Symbols.hpp"
 #include "data/Value.hpp"
 #include "error/Debug.hpp"
+#include "error/Error.hpp"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <stack>
+#include <llvm/Support/TimeProfiler.h>
 
 #define SWITCHNODE(fun, nodes) node = fun(nodes); break;
 
@@ -13,16 +17,45 @@ using nvyc::NASTNode;
 using nvyc::NodeStream;
 using nvyc::NodeType;
 
-int forwardDepth = 0;
-bool isNativeFunction = false;
-
 std::vector<std::unique_ptr<NASTNode>> nvyc::Parser::parseStream(NodeStream& stream) {
+    auto scope = context.getStats().time("parse");
     std::vector<std::unique_ptr<NASTNode>> nodes;
 
     while(stream.hasNext()) {
+        llvm::TimeTraceScope trace("parseDeclaration", [&] { return declarationDetail(stream); });
         nodes.push_back(std::move(parse(stream)));
     }
 
+    if(context.getStats().countersEnabled()) {
+        uint64_t count = 0;
+        for(const auto& node : nodes) {
+            if(node) count += nvyc::ParserUtils::countNodes(node.get());
+        }
+        context.getStats().addCounter("ast nodes", count);
+    }
+
+    if(context.getStats().memoryEnabled()) {
+        MemoryUsage nodeUsage, stringUsage;
+        for(const auto& node : nodes) {
+            if(node) node->memoryUsage(nodeUsage, stringUsage);
+        }
+        context.getStats().addStructure("NASTNode trees", nodeUsage);
+        context.getStats().addStructure("Value strings (AST)", stringUsage);
+    }
+
+    return nodes;
+}
+
+// Streaming front end, each declaration's tokens are freed as soon as it is parsed
+std::vector<std::unique_ptr<NASTNode>> nvyc::Parser::parseStream(LexerStream& source) {
+    std::vector<std::unique_ptr<NASTNode>> nodes;
+
+    while(std::unique_ptr<NodeStream> declaration = source.next()) {
+        for(auto& node : parseStream(*declaration)) {
+            nodes.push_back(std::move(node));
+        }
+    }
+
     return nodes;
 }
 
@@ -37,6 +70,10 @@ std::unique_ptr<NASTNode> nvyc::Parser::parse(NodeStream& stream) {
             SWITCHNODE(parseModule, stream);
         case NodeType::FUNCTION:
             SWITCHNODE(parseFunction, stream);
+        case NodeType::PUBLIC:
+        case NodeType::PRIVATE:
+        case NodeType::STATIC:
+            SWITCHNODE(parseModifiers, stream);
         case NodeType::NATIVE:
             SWITCHNODE(parseNativeFunction, stream);
         case NodeType::VARDEF:
@@ -69,6 +106,17 @@ std::unique_ptr<NASTNode> nvyc::Parser::parse(NodeStream& stream) {
     return node;
 }
 
+// Shown on -ftime-trace spans, e.g. "FUNCTION add (line 3)"
+std::string nvyc::Parser::declarationDetail(const NodeStream& stream) {
+    std::string detail = symbols::nodeTypeToString(stream.getType());
+    // A declaration cut off after its keyword has no name, the type alone has to do
+    bool named = stream.getIndex() + 1 < stream.size();
+    if(named && (stream.getType() == NodeType::FUNCTION || stream.getType() == NodeType::MODULE)) {
+        detail += " " + stream.getValue(stream.getIndex() + 1).asString();
+    }
+    return detail + " (line " + std::to_string(stream.getToken().line) + ")";
+}
+
 // **********************************************
 // *             Block Statements               *
 // **********************************************
@@ -81,6 +129,7 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseModule(NodeStream& stream) {
     auto moduleNode = nvyc::ParserUtils::createModule(currentModule);
 
     while(stream.getType() != NodeType::CLOSEBRACE) {
+        llvm::TimeTraceScope trace("parseDeclaration", [&] { return declarationDetail(stream); });
         auto node = parse(stream);
         std::cout << node->asString() << std::endl;
         moduleNode->addSubnode(std::move(node));
@@ -114,9 +163,15 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseFunction(NodeStream& stream) {
     auto returnType = stream.getType();
     nvyc::ParserUtils::setFunctionReturnType(*functionNode, returnType);
 
+    // Attributes sit between the return type and the body, leaving the stream on their ')'
+    while(stream.getNext().type == NodeType::DIRTYPE) {
+        stream.forward(1);
+        nvyc::ParserUtils::addFunctionAttribute(*functionNode, parseFunctionAttribute(stream));
+    }
+
     // Walk through body and parse
 
-    if(!isNativeFunction) {
+    if(!context.isNativeFunction()) {
         stream.forward(nvyc::ParserUtils::FUNCTION_FORWARD_FIRSTEXPR);
         std::vector<std::unique_ptr<NASTNode>> bodyNodes = parseBodyNodes(stream);
         for(auto& bodyNode : bodyNodes) {
@@ -128,6 +183,62 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseFunction(NodeStream& stream) {
 
 }
 
+/*
+    multiversion(avx2, avx512f, default)
+    Each argument runs to the next ',' or ')', so names lexed as several
+    tokens (sse4.2) come back joined.
+*/
+std::unique_ptr<NASTNode> nvyc::Parser::parseFunctionAttribute(NodeStream& stream) {
+    auto attributeNode = nvyc::ParserUtils::createNode(NodeType::DIRTYPE, stream.getValue());
+    stream.forward(2); // Move past '('
+
+    std::string argument;
+    while(stream.hasNext() && stream.getType() != NodeType::CLOSEPARENS) {
+        if(stream.getType() == NodeType::COMMADELIMIT) {
+            attributeNode->addSubnode(nvyc::ParserUtils::createNode(NodeType::DIRVALUE, Value(argument)));
+            argument.clear();
+        }
+        else argument += stream.getValue().asString();
+        stream.forward(1);
+    }
+    if(!argument.empty()) attributeNode->addSubnode(nvyc::ParserUtils::createNode(NodeType::DIRVALUE, Value(argument)));
+
+    return attributeNode;
+}
+
+/*
+    public static func add(int32 a, int32 b) -> int32 { ... }
+    Only functions take modifiers. They decide linkage, anything not public
+    is internal to its module (see Passes::mangleFunctions).
+*/
+std::unique_ptr<NASTNode> nvyc::Parser::parseModifiers(NodeStream& stream) {
+    std::vector<NodeType> modifiers;
+    while(
+        stream.getType() == NodeType::PUBLIC ||
+        stream.getType() == NodeType::PRIVATE ||
+        stream.getType() == NodeType::STATIC
+    ) {
+        modifiers.push_back(stream.getType());
+        stream.forward(1);
+    }
+
+    if(stream.getType() != NodeType::FUNCTION) {
+        nvyc::Error::nvyerr_failcompile(1, "Modifiers can only be applied to functions, found " + symbols::nodeTypeToString(stream.getType()));
+    }
+
+    bool isPublic = std::find(modifiers.begin(), modifiers.end(), NodeType::PUBLIC) != modifiers.end();
+    bool isPrivate = std::find(modifiers.begin(), modifiers.end(), NodeType::PRIVATE) != modifiers.end();
+    if(isPublic && isPrivate) {
+        nvyc::Error::nvyerr_failcompile(1, "Function " + stream.getNext().getValue().asString() + " cannot be both public and private");
+    }
+
+    auto functionNode = parseFunction(stream);
+    for(NodeType modifier : modifiers) {
+        nvyc::ParserUtils::addFunctionAttribute(*functionNode, nvyc::ParserUtils::createNode(modifier, NULL_VALUE));
+    }
+    return functionNode;
+}
+
 std::unique_ptr<NASTNode> nvyc::Parser::parseNativeFunction(NodeStream& stream) {
     auto nativeNode = nvyc::ParserUtils::createNode(NodeType::NATIVE, Value("native"));
     stream.forward(1); // Move past 'native'
@@ -258,7 +369,7 @@ std::vector<std::unique_ptr<NASTNode>> nvyc::Parser::parseBodyNodes(NodeStream&
     std::stack<int> braces;
     braces.push(1);
 
-    while(!braces.empty()) {
+    while(!braces.empty() && stream.hasNext()) {
         type = stream.getType();
 
         switch(type) {
@@ -307,59 +418,57 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseVardef(NodeStream& stream) {
     return variableNode;
 }
 
+// Each argument is parsed over its own tokens, up to the ',' or ')' that ends it. Leaves the stream past the call's ')'
 std::unique_ptr<NASTNode> nvyc::Parser::parseFunctionCall(NodeStream& stream) {
     std::string funName = stream.getValue().asString();
     auto callNode = nvyc::ParserUtils::createFunctionCall(funName);
 
+    int start = stream.getIndex() + 2;
     auto args = getFunctionCallArgs(stream);
     for(int arg : args) {
-        if(stream.getToken(arg).getType() == NodeType::COMMADELIMIT) arg++;
-        stream.moveTo(arg);
-
-        auto expression = parseExpression(stream, getExpression(stream, nvyc::ParserUtils::ENCLOSED_EXPRESSION));
-        nvyc::ParserUtils::addFunctionCallArg(*callNode, std::move(expression));
+        if(arg > start) {
+            stream.moveTo(start);
+            auto expression = parseExpression(stream, arg - start - 1);
+            nvyc::ParserUtils::addFunctionCallArg(*callNode, std::move(expression));
+        }
+        start = arg + 1;
     }
+    if(args.empty()) start++; // Past the ')' of f()
+
+    stream.moveTo(std::min(start, stream.size() - 1));
     return callNode;
 
 }
 
+// Commas at the call's own level, then its ')'. Nested parentheses are skipped through the stream's match table
 std::vector<int> nvyc::Parser::getFunctionCallArgs(NodeStream& stream) {
-    NodeType type;
     std::vector<int> nodes;
-
-    auto it = stream.iterator();
+    int start = stream.getIndex();
 
     // Empty call case, func ( )  
-    it.forward(2);
-
-    if(it.get().getType() == NodeType::CLOSEPARENS) {
+    if(start + 2 >= stream.size() || stream.getType(start + 2) == NodeType::CLOSEPARENS) {
         return nodes;
     }
-    
-    std::stack<int> args;
-    args.push(1);
 
-    while(!args.empty()) {
-        type = it.get().getType();
+    // An unclosed call ends at the last token
+    int close = stream.matchingDelimiter(start + 1);
+    int end = close < 0 ? stream.size() : close;
 
-        if(type == NodeType::OPENPARENS) {
-            args.push(1);
-        }
+    for(int i = start + 2; i < end; i++) {
+        NodeType type = stream.getType(i);
 
-        else if(type == NodeType::CLOSEPARENS) {
-            args.pop();
-            if(args.empty()) nodes.push_back(it.idx_it);
-        }
-
-        else if(args.size() == 1 && type == NodeType::COMMADELIMIT) {
-            nodes.push_back(it.idx_it);
+        if(type == NodeType::OPENPARENS) {
+            int inner = stream.matchingDelimiter(i);
+            if(inner < 0) break;
+            i = inner;
         }
 
-        if(!args.empty() && it.validNext()) {
-            it.next();
+        else if(type == NodeType::COMMADELIMIT) {
+            nodes.push_back(i);
         }
     }
 
+    if(close >= 0) nodes.push_back(close);
     return nodes;
 }
 
@@ -377,7 +486,7 @@ int nvyc::Parser::getExpression(const NodeStream& stream, bool enclosed) {
     if(!enclosed) {
         while(
             it.validNext() && 
-            !nvyc::symbols::START_SYMBOLS.count(it.get().getType()) &&
+            !nvyc::symbols::isStartSymbol(it.get().getType()) &&
             it.get().getType() != NodeType::ENDOFLINE
         ) {
             len++;
@@ -415,6 +524,20 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseExpression(NodeStream& stream, int
             expectUnary = false;
         }
 
+        // x.y.z is lexed as VARIABLE ATTRIB VARIABLE ..., joined back for accessStructMember
+        else if(tokenType == NodeType::VARIABLE && stream.getIndex() + 2 < stream.size() && stream.getType(stream.getIndex() + 1) == NodeType::ATTRIB) {
+            int start = stream.getIndex(), last = start;
+            std::string chain = stream.getValue().asString();
+            while(last + 2 < stream.size() && stream.getType(last + 1) == NodeType::ATTRIB && stream.getType(last + 2) == NodeType::VARIABLE) {
+                chain += "." + stream.getValue(last + 2).asString();
+                last += 2;
+            }
+            valueStack.push(nvyc::ParserUtils::accessStructMember(chain));
+            stream.moveTo(last);
+            dist += last - start;
+            expectUnary = false;
+        }
+
         else if(tokenType == NodeType::ARRAY_TYPE) {
             // valueStack.push(parseArray(...));
             expectUnary = false;
@@ -426,20 +549,23 @@ std::unique_ptr<NASTNode> nvyc::Parser::parseExpression(NodeStream& stream, int
         }
 
         // Can fold together with literals and variables
-        else if(nvyc::symbols::MEMORY_SYMBOLS.count(tokenType)) {
+        else if(nvyc::symbols::isMemory(tokenType)) {
             valueStack.push(nvyc::ParserUtils::createNode(stream.getType(), stream.getValue()));
             expectUnary = false;
         }
 
-        else if(nvyc::symbols::LITERAL_SYMBOLS.count(tokenType) || tokenType == NodeType::VARIABLE) {
+        else if(nvyc::symbols::isLiteral(tokenType) || tokenType == NodeType::VARIABLE) {
             valueStack.push(nvyc::ParserUtils::createNode(stream.getType(), stream.getValue()));
             expectUnary = false;
         }
 
         else if(tokenType == NodeType::FUNCTIONCALL) {
+            // The call's tokens count against this expression's length, then the loop steps past its ')'
+            int call = stream.getIndex();
             int depth = nvyc::ParserUtils::getDepth(stream, NodeType::OPENPARENS, NodeType::CLOSEPARENS);
             valueStack.push(parseFunctionCall(stream));
-            stream.forward(depth);
+            stream.moveTo(call + depth);
+            dist += depth;
             expectUnary = false;
         }
 
@@ -509,7 +635,7 @@ void nvyc::Parser::processOperator(std::stack<NodeType>& operatorStack, std::sta
     operatorStack.pop();
 
     // If the current operator is unary
-    if(nvyc::symbols::UNARY_SYMBOLS.count(operation)) {
+    if(nvyc::symbols::isUnary(operation)) {
         auto rhs = std::move(valueStack.top()); valueStack.pop();
         auto node = nvyc::ParserUtils::createNode(operation, Value("VOID"));
         node->addSubnode(std::move(rhs));
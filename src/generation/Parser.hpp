@@ -3,6 +3,7 @@
 #include "data/NASTNode.hpp"
 #include "data/NodeStream.hpp"
 #include "data/NodeType.hpp"
+#include "utils/CompilationContext.hpp"
 #include <stack>
 #include <vector>
 #include <memory>
@@ -13,9 +14,13 @@ using nvyc::NodeType;
 
 namespace nvyc {
 
+    class LexerStream;
+
     class Parser {
 
         private:
+            CompilationContext& context;
+
             // Module
             std::string currentModule;
             bool insideModule = false;
@@ -26,6 +31,8 @@ namespace nvyc {
 
             // Block statements
             std::unique_ptr<NASTNode> parseFunction(NodeStream& stream);
+            std::unique_ptr<NASTNode> parseFunctionAttribute(NodeStream& stream);
+            std::unique_ptr<NASTNode> parseModifiers(NodeStream& stream);
             std::unique_ptr<NASTNode> parseNativeFunction(NodeStream& stream);
             std::unique_ptr<NASTNode> parseFunctionCall(NodeStream& stream);
             std::unique_ptr<NASTNode> parseForLoop(NodeStream& stream);
@@ -46,10 +53,14 @@ namespace nvyc {
             std::vector<NodeStream*> parselist(NodeStream& root);
             std::vector<std::unique_ptr<NASTNode>> parseBodyNodes(NodeStream& stream);
             std::vector<int> getFunctionCallArgs(NodeStream& stream);
+            std::string declarationDetail(const NodeStream& stream);
 
         public:
+            Parser(CompilationContext& ctx) : context(ctx) {}
+
             std::unique_ptr<NASTNode> parse(NodeStream& stream);
             std::vector<std::unique_ptr<NASTNode>> parseStream(NodeStream& stream);
+            std::vector<std::unique_ptr<NASTNode>> parseStream(LexerStream& source);
 
     }; // Parser
 
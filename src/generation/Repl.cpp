@@ -0,0 +1,260 @@
+#include "Repl.hpp"
+#include "LLVMEmission.hpp"
+#include "LexerStream.hpp"
+#include "Parser.hpp"
+#include "data/Symbols.hpp"
+#include "error/Error.hpp"
+#include "passes/CompilationPasses.hpp"
+#include "passes/PassManager.hpp"
+#include "processing/StreamRebuilder.hpp"
+#include "utils/JITObjectCache.hpp"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+
+namespace nvyc {
+
+    static std::string jitCacheDirectory(CompileOptions& options) {
+        if(!options.get_jit_cache()) return "";
+        if(!options.get_jit_cache_dir().empty()) return options.get_jit_cache_dir();
+        return JITObjectCache::defaultDirectory();
+    }
+
+    Repl::Repl(CompilationContext& ctx, CompileOptions& options) :
+        context(ctx),
+        builder(ctx, ctx.getModuleName()),
+        session(ctx, options.get_lazy_jit(), jitCacheDirectory(options), options.get_jit_cache_size()),
+        level(options.get_opt_level())
+    {}
+
+    int Repl::run(std::istream& in, std::ostream& out) {
+        if(!session.valid()) return 1;
+
+        std::vector<std::string> lines;
+        std::string line;
+
+        out << "nvy> " << std::flush;
+        while(std::getline(in, line)) {
+            if(lines.empty()) {
+                if(line == ":quit" || line == ":q") break;
+                if(line.find_first_not_of(" \t") == std::string::npos) {
+                    out << "nvy> " << std::flush;
+                    continue;
+                }
+            }
+
+            lines.push_back(line);
+            if(isComplete(lines)) {
+                evaluate(lines, out);
+                lines.clear();
+            }
+            out << (lines.empty() ? "nvy> " : "...> ") << std::flush;
+        }
+
+        return 0;
+    }
+
+    // Balanced braces and a closing ';' or '}', bare expressions may leave the ';' off
+    bool Repl::isComplete(const std::vector<std::string>& lines) {
+        int nesting = 0;
+        bool quoted = false;
+        for(const std::string& line : lines) {
+            for(char c : line) {
+                if(c == '"') quoted = !quoted;
+                else if(!quoted && c == '{') nesting++;
+                else if(!quoted && c == '}') nesting--;
+            }
+        }
+        if(nesting > 0 || quoted) return false;
+
+        const std::string& last = lines.back();
+        size_t end = last.find_last_not_of(" \t");
+        if(end == std::string::npos) return false;
+        return last[end] == ';' || last[end] == '}' || !isDeclaration(lines.front());
+    }
+
+    bool Repl::isDeclaration(const std::string& line) {
+        std::string word;
+        std::istringstream(line) >> word;
+        return word == "func" || word == "let" || word == "native" || word == "module" || word == "struct" ||
+               word == "public" || word == "private" || word == "static";
+    }
+
+    bool Repl::evaluate(std::vector<std::string>& lines, std::ostream& out) {
+        auto scope = context.getStats().time("replEntry");
+        std::string moduleName = "__repl_" + std::to_string(entries);
+        builder.resetModule(moduleName);
+
+        // Bare expressions are evaluated as a binding, so the result can be reused
+        if(!isDeclaration(lines.front())) {
+            lines.front() = "let it = " + lines.front();
+            std::string& last = lines.back();
+            if(last[last.find_last_not_of(" \t")] != ';') last += ";";
+        }
+
+        Processing::StreamRebuilder rebuilder(lines);
+        Passes::PassManager passes(context, rebuilder);
+        LexerStream source(context, lines, &passes);
+        Parser parser(context);
+
+        // The entry's lets and references are bound to values of its own module, which the JIT owns or frees
+        // once it is added. They are dropped again afterwards, and later entries rebind them through declareReferences
+        builder.getSymbols().pushScope();
+
+        Entry entry;
+        while(std::unique_ptr<NodeStream> declaration = source.next()) {
+            for(auto& node : parser.parseStream(*declaration)) {
+                if(node) node = passes.executeDeclarationPasses(std::move(node));
+                if(!node) continue;
+
+                declareReferences(node.get());
+                compileEntryNode(node.get(), entry);
+            }
+        }
+
+        std::string initName;
+        if(entry.init) {
+            initName = entry.init->getName().str();
+            builder.setInsertionPoint(&entry.init->back());
+            builder.getBuilder().CreateRetVoid();
+        }
+
+        if(level != OptLevel::O0) builder.optimize(level);
+        bool added = session.addModule(builder.takeModule());
+        builder.getSymbols().popScope();
+        if(!added) return false;
+        entries++;
+
+        for(auto& [name, function] : entry.functions) functions[name] = function;
+        for(auto& [name, binding] : entry.bindings) bindings[name] = binding;
+
+        if(entry.init) {
+            auto init = reinterpret_cast<void (*)()>(session.lookup(initName));
+            if(!init) {
+                Error::nvyerr_out("Could not find " + initName + " in the JIT");
+                return false;
+            }
+            init();
+        }
+
+        for(auto& [name, binding] : entry.bindings) printBinding(out, name);
+        return true;
+    }
+
+    /*
+        Earlier entries live in other modules. Anything this entry uses from
+        them gets an extern declaration here. The JIT resolves it to the
+        original definition, and SymbolStorage is pointed at the declaration.
+    */
+    void Repl::declareReferences(const NASTNode* node) {
+        llvm::Module* module = builder.getModule();
+
+        if(node->getType() == NodeType::VARIABLE && node->getSubnodes().empty()) {
+            auto it = bindings.find(node->getData().asString());
+            if(it != bindings.end()) {
+                const Binding& binding = it->second;
+                llvm::GlobalVariable* global = module->getNamedGlobal(binding.symbol);
+                if(!global) {
+                    global = new llvm::GlobalVariable(*module, binding.llvmType, false, llvm::GlobalValue::ExternalLinkage, nullptr, binding.symbol);
+                }
+                builder.getSymbols().storeAlloca(it->first, global);
+                builder.getSymbols().storeVarType(it->first, binding.nvyType, binding.llvmType);
+            }
+        }
+
+        else if(node->getType() == NodeType::FUNCTIONCALL) {
+            for(const std::string& target : Passes::resolveCallTargets(context, node->getData().asString())) {
+                auto it = functions.find(target);
+                if(it != functions.end() && !module->getNamedValue(target)) {
+                    llvm::Function* declaration = llvm::Function::Create(it->second.type, llvm::Function::ExternalLinkage, target, module);
+                    declaration->setCallingConv(it->second.callingConv);
+                    builder.getSymbols().storeFunction(target, declaration);
+                }
+            }
+        }
+
+        for(const auto& subnode : node->getSubnodes()) {
+            if(subnode) declareReferences(subnode.get());
+        }
+    }
+
+    void Repl::compileEntryNode(const NASTNode* node, Entry& entry) {
+        llvm::Module* module = builder.getModule();
+
+        switch(node->getType()) {
+            case NodeType::MODULE: {
+                for(const auto& subnode : node->getSubnodes()) {
+                    if(subnode) compileEntryNode(subnode.get(), entry);
+                }
+                break;
+            }
+
+            case NodeType::FUNCTION:
+            case NodeType::NATIVE: {
+                // Later entries live in other modules, so every function the session defines is exported
+                std::string name = Passes::functionOf(node)->getData().asString();
+                context.getExportedFunctions().insert(name);
+                compileNode(&builder, node);
+                // A multiversioned function is an ifunc by now, not a Function
+                llvm::GlobalValue* function = module->getNamedValue(name);
+                entry.functions.emplace_back(name, Callee{llvm::cast<llvm::FunctionType>(function->getValueType()), EmissionBuilder::callingConvOf(function)});
+                break;
+            }
+
+            // Top-level let: a global, initialized by this entry's init function
+            case NodeType::VARDEF: {
+                if(!entry.init) {
+                    llvm::FunctionType* initType = llvm::FunctionType::get(builder.getBuilder().getVoidTy(), false);
+                    entry.init = llvm::Function::Create(initType, llvm::Function::ExternalLinkage, module->getName() + "_init", module);
+                    builder.createBlock(entry.init, "entry");
+                }
+                builder.setInsertionPoint(&entry.init->back());
+
+                std::string name = node->getData().asString();
+                EmissionBuilder::ResultType type;
+                llvm::Value* value = compileExpression(&builder, node->getSubnode(0), EXPR_ARITH, &type);
+                if(!value) {
+                    Error::nvyerr_out("Cannot evaluate the value of " + name);
+                    break;
+                }
+
+                std::string symbol = module->getName().str() + "_" + name;
+                auto global = new llvm::GlobalVariable(*module, type.llvmType, false, llvm::GlobalValue::ExternalLinkage,
+                                                       llvm::Constant::getNullValue(type.llvmType), symbol);
+                builder.storeToVariable(global, value);
+
+                builder.getSymbols().storeAlloca(name, global);
+                builder.getSymbols().storeVarType(name, type.nvyType, type.llvmType);
+                entry.bindings.emplace_back(name, Binding{symbol, type.nvyType, type.llvmType});
+                break;
+            }
+
+            default:
+                Error::nvyerr_out("Cannot evaluate a top-level " + symbols::nodeTypeToString(node->getType()));
+                break;
+        }
+    }
+
+    void Repl::printBinding(std::ostream& out, const std::string& name) {
+        const Binding& binding = bindings.at(name);
+        void* address = session.lookup(binding.symbol);
+        out << name << " : " << symbols::nodeTypeToString(binding.nvyType) << " = ";
+
+        if(!address) {
+            out << "?\n";
+            return;
+        }
+
+        switch(binding.nvyType) {
+            case NodeType::INT32: out << *static_cast<int32_t*>(address); break;
+            case NodeType::INT64: out << *static_cast<int64_t*>(address); break;
+            case NodeType::FP32:  out << *static_cast<float*>(address); break;
+            case NodeType::FP64:  out << *static_cast<double*>(address); break;
+            default:              out << address; break;
+        }
+        out << "\n";
+    }
+
+} // namespace nvyc
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "data/NASTNode.hpp"
+#include "data/NodeType.hpp"
+#include "utils/CompilationContext.hpp"
+#include "utils/CompileOptions.hpp"
+#include "utils/EmissionBuilder.hpp"
+#include "utils/JITSession.hpp"
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Interactive session for --repl. Every entry (a declaration, a let, or
+        a bare expression) is lexed, parsed and emitted into its own small
+        module and added to one live JITSession. Only the new fragment is
+        compiled, never the whole session.
+
+        The EmissionBuilder persists across entries. Each entry binds its
+        symbols in a SymbolStorage scope of its own, popped once the module
+        is handed to the JIT, so a failed entry leaves nothing pointing into
+        its module. Top-level lets become globals, and their initializers
+        run in a per-entry init function. A bare expression is bound to "it". Later
+        entries get extern declarations for just the globals and functions
+        they refer to, and the JIT links them to the earlier modules.
+    */
+    class Repl {
+        private:
+            struct Binding {
+                std::string symbol; // Global in the module that defined it
+                NodeType nvyType;
+                llvm::Type* llvmType;
+            };
+
+            // What a declaration in a later module needs to match the definition
+            struct Callee {
+                llvm::FunctionType* type;
+                llvm::CallingConv::ID callingConv;
+            };
+
+            // What one entry adds, committed only once its module is in the JIT
+            struct Entry {
+                llvm::Function* init = nullptr;
+                std::vector<std::pair<std::string, Binding>> bindings;
+                std::vector<std::pair<std::string, Callee>> functions;
+            };
+
+            CompilationContext& context;
+            EmissionBuilder builder;
+            JITSession session;
+            OptLevel level;
+            int entries = 0;
+
+            std::unordered_map<std::string, Binding> bindings;
+            std::unordered_map<std::string, Callee> functions;
+
+            static bool isComplete(const std::vector<std::string>& lines);
+            static bool isDeclaration(const std::string& line);
+
+            void declareReferences(const NASTNode* node);
+            void compileEntryNode(const NASTNode* node, Entry& entry);
+            void printBinding(std::ostream& out, const std::string& name);
+
+        public:
+            Repl(CompilationContext& ctx, CompileOptions& options);
+
+            Repl(const Repl&) = delete;
+            Repl& operator=(const Repl&) = delete;
+
+            // Reads entries until EOF or :quit, returns the exit code
+            int run(std::istream& in, std::ostream& out);
+
+            // One complete entry, false if it could not be added to the session
+            bool evaluate(std::vector<std::string>& lines, std::ostream& out);
+    };
+
+} // namespace nvyc
@@ -0,0 +1,244 @@
+#include "CompilationPasses.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "data/NodeType.hpp"
+#include "data/NASTNode.hpp"
+#include "data/Symbols.hpp"
+#include "utils/ParserUtils.hpp"
+
+using nvyc::NodeType;
+using nvyc::NASTNode;
+
+namespace nvyc::Passes {
+
+    /*
+        Drops every FUNCTION/NATIVE that can't be reached from main or a
+        registered entry point, so they never reach compileFunction/compileNative.
+
+        Calls still use source names (see resolveFunctionCall), so a call to
+        "add" keeps every overload that mangleFunctions produced for it.
+        Without any root (library builds) nothing is removed.
+    */
+    bool eliminateDeadFunctions(CompilationContext& context, std::vector<std::unique_ptr<NASTNode>>& nodes) {
+        std::unordered_map<std::string, const NASTNode*> definitions;
+        std::vector<std::string> worklist;
+
+        // Top-level function definitions, either loose or inside modules
+        auto define = [&](const NASTNode* node) {
+            const NASTNode* function = functionOf(node);
+            if(function) definitions[function->getData().asString()] = function;
+        };
+
+        for(const auto& node : nodes) {
+            if(!node) continue;
+            if(node->getType() == NodeType::MODULE) {
+                for(const auto& subnode : node->getSubnodes()) {
+                    if(subnode) define(subnode.get());
+                }
+            }
+            else define(node.get());
+        }
+
+        // Roots, only names with a definition here count, resolveCallTargets always returns the name it was given
+        auto addRoot = [&](const std::string& name) {
+            if(definitions.contains(name)) worklist.push_back(name);
+        };
+
+        for(const std::string& target : resolveCallTargets(context, "main")) {
+            addRoot(target);
+        }
+        for(const std::string& entry : context.getEntryPoints()) {
+            for(const std::string& target : resolveCallTargets(context, entry)) {
+                addRoot(target);
+            }
+        }
+        // Public functions can be called from other modules
+        for(const std::string& exported : context.getExportedFunctions()) {
+            addRoot(exported);
+        }
+
+        // Anything outside a function (globals) runs unconditionally
+        std::vector<std::string> globalCalls;
+        for(const auto& node : nodes) {
+            if(!node) continue;
+            if(node->getType() == NodeType::MODULE) {
+                for(const auto& subnode : node->getSubnodes()) {
+                    if(subnode && !functionOf(subnode.get())) collectCalls(subnode.get(), globalCalls);
+                }
+            }
+            else if(!functionOf(node.get())) collectCalls(node.get(), globalCalls);
+        }
+        for(const std::string& call : globalCalls) {
+            for(const std::string& target : resolveCallTargets(context, call)) {
+                addRoot(target);
+            }
+        }
+
+        if(worklist.empty()) {
+            context.getDebug().debug("No main, entry point or public function defined, keeping every function");
+            return false;
+        }
+
+        std::unordered_set<std::string> reachable;
+        std::vector<std::string> calls;
+
+        while(!worklist.empty()) {
+            std::string name = std::move(worklist.back());
+            worklist.pop_back();
+
+            auto it = definitions.find(name);
+            if(it == definitions.end() || !reachable.insert(name).second) continue;
+
+            calls.clear();
+            collectCalls(it->second, calls);
+            for(const std::string& call : calls) {
+                for(const std::string& target : resolveCallTargets(context, call)) {
+                    if(!reachable.contains(target)) worklist.push_back(target);
+                }
+            }
+        }
+
+        size_t removed = 0;
+        auto isDead = [&](const std::unique_ptr<NASTNode>& node) {
+            const NASTNode* function = node ? functionOf(node.get()) : nullptr;
+            bool dead = function && !reachable.contains(function->getData().asString());
+            if(dead) removed++;
+            return dead;
+        };
+
+        for(auto& node : nodes) {
+            if(node && node->getType() == NodeType::MODULE) {
+                std::erase_if(node->getSubnodes(), isDead);
+            }
+        }
+        std::erase_if(nodes, isDead);
+
+        context.getDebug().debug("Removed " + std::to_string(removed) + " unreachable functions");
+        return removed > 0;
+    }
+
+    // FUNCTION node itself, or the declaration under a NATIVE
+    const NASTNode* functionOf(const NASTNode* node) {
+        if(node->getType() == NodeType::FUNCTION) return node;
+        if(node->getType() == NodeType::NATIVE && !node->getSubnodes().empty()) return node->getSubnode(0);
+        return nullptr;
+    }
+
+    void collectCalls(const NASTNode* node, std::vector<std::string>& calls) {
+        if(node->getType() == NodeType::FUNCTIONCALL) {
+            calls.push_back(node->getData().asString());
+        }
+        for(const auto& subnode : node->getSubnodes()) {
+            if(subnode) collectCalls(subnode.get(), calls);
+        }
+    }
+
+    // A call name is either a source name that was mangled, or already final (natives, mangled names)
+    std::vector<std::string> resolveCallTargets(CompilationContext& context, const std::string& name) {
+        std::vector<std::string> targets;
+        auto& aliases = context.getFunctionAliases();
+
+        auto it = aliases.find(name);
+        if(it != aliases.end()) targets = it->second;
+        targets.push_back(name);
+
+        return targets;
+    }
+
+
+    /*
+        Resolves the NodeType of every expression node bottom-up and stores it
+        on the node. Operators get the same promotion arithmeticPrecedence would
+        compute, so compileExpression only has to read the annotation.
+
+        Anything that can't be typed yet (struct members, unknown calls) stays
+        INVALID and the emitter falls back to inferring it.
+    */
+    bool annotateTypes(CompilationContext& context, std::vector<std::unique_ptr<NASTNode>>& nodes) {
+        // Kept on the context so declarations streamed in one at a time still see earlier signatures
+        TypeScope& functions = context.getFunctionReturnTypes();
+        TypeScope scope;
+
+        auto declare = [&](const NASTNode* node) {
+            const NASTNode* function = functionOf(node);
+            if(!function) return;
+            const NASTNode* returnNode = function->getSubnode(nvyc::ParserUtils::FUNCTION_RETURN);
+            if(returnNode->getSubnodes().empty()) return;
+            functions[function->getData().asString()] = symbols::declaredToLiteral(returnNode->getSubnode(0)->getType());
+        };
+
+        for(const auto& node : nodes) {
+            if(!node) continue;
+            if(node->getType() == NodeType::MODULE) {
+                for(const auto& subnode : node->getSubnodes()) {
+                    if(subnode) declare(subnode.get());
+                }
+            }
+            else declare(node.get());
+        }
+
+        for(auto& node : nodes) {
+            if(node) annotateNode(context, node.get(), scope, functions);
+        }
+
+        return true;
+    }
+
+    NodeType annotateNode(CompilationContext& context, NASTNode* node, TypeScope& scope, const TypeScope& functions) {
+        NodeType ty = node->getType();
+        NodeType resolved = NodeType::INVALID;
+
+        if(ty == NodeType::FUNCTION) {
+            scope.clear();
+            for(const auto& paramNode : node->getSubnode(nvyc::ParserUtils::FUNCTION_ARGS)->getSubnodes()) {
+                scope[paramNode->getData().asString()] = symbols::declaredToLiteral(paramNode->getType());
+            }
+        }
+
+        std::vector<NodeType> subtypes;
+        for(auto& subnode : node->getSubnodes()) {
+            subtypes.push_back(subnode ? annotateNode(context, subnode.get(), scope, functions) : NodeType::INVALID);
+        }
+
+        if(symbols::isLiteral(ty)) {
+            resolved = ty;
+        }
+
+        else if(ty == NodeType::VARIABLE && subtypes.empty()) {
+            auto it = scope.find(node->getData().asString());
+            if(it != scope.end()) resolved = it->second;
+        }
+
+        else if(ty == NodeType::FUNCTIONCALL) {
+            for(const std::string& target : resolveCallTargets(context, node->getData().asString())) {
+                auto it = functions.find(target);
+                if(it != functions.end()) {
+                    resolved = it->second;
+                    break;
+                }
+            }
+        }
+
+        else if(symbols::isArithmetic(ty) || symbols::isLogical(ty)) {
+            resolved = NodeType::INT32;
+            for(NodeType subtype : subtypes) {
+                if(subtype == NodeType::INVALID) {
+                    resolved = NodeType::INVALID;
+                    break;
+                }
+                resolved = symbols::promoteNumeric(resolved, subtype);
+            }
+        }
+
+        else if(ty == NodeType::VARDEF && !subtypes.empty()) {
+            scope[node->getData().asString()] = subtypes[0];
+        }
+
+        node->setResolvedType(resolved);
+        return resolved;
+    }
+
+}
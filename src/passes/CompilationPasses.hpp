@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include "data/NodeType.hpp"
+#include "data/NASTNode.hpp"
+#include "utils/CompilationContext.hpp"
+#include "ParserPasses.hpp"
+
+using nvyc::NodeType;
+using nvyc::NASTNode;
+
+namespace nvyc::Passes {
+
+    // Dead function elimination
+    bool eliminateDeadFunctions(CompilationContext& context, std::vector<std::unique_ptr<NASTNode>>& nodes);
+    const NASTNode* functionOf(const NASTNode* node);
+    void collectCalls(const NASTNode* node, std::vector<std::string>& calls);
+    std::vector<std::string> resolveCallTargets(CompilationContext& context, const std::string& name);
+
+    // Type annotation
+    bool annotateTypes(CompilationContext& context, std::vector<std::unique_ptr<NASTNode>>& nodes);
+    NodeType annotateNode(CompilationContext& context, NASTNode* node, TypeScope& scope, const TypeScope& functions);
+
+}
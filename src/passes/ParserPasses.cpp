@@ -4,11 +4,13 @@
 #include <sstream>
 #include <vector>
 #include <unordered_set>
+#include <cstdint>
 #include "data/NodeType.hpp"
 #include "data/Symbols.hpp"
 #include "data/NASTNode.hpp"
 #include "data/Value.hpp"
 #include "processing/StreamRebuilder.hpp"
+#include "utils/ParserUtils.hpp"
 
 using nvyc::NodeType;
 using nvyc::NASTNode;
@@ -17,10 +19,26 @@ using nvyc::NodeType;
 
 namespace nvyc::Passes {
 
-    std::unordered_set<std::string> functionNames;
+    // Only these stay visible outside the module, everything else becomes internal and fastcc
+    static void recordExport(CompilationContext& context, const NASTNode& function, const std::string& sourceName, const std::string& name) {
+        if(
+            sourceName == "main" ||
+            context.getEntryPoints().contains(sourceName) ||
+            context.getEntryPoints().contains(name) ||
+            nvyc::ParserUtils::hasFunctionModifier(function, NodeType::PUBLIC)
+        ) {
+            context.getExportedFunctions().insert(name);
+        }
+    }
 
-    std::unique_ptr<NASTNode> mangleFunctions(std::unique_ptr<NASTNode> module) {
+    std::unique_ptr<NASTNode> mangleFunctions(CompilationContext& context, std::unique_ptr<NASTNode> module) {
+        // Functions outside a module keep their name
+        if(module->getType() == NodeType::FUNCTION) {
+            const std::string name = module->getData().asString();
+            recordExport(context, *module, name, name);
+        }
         if(module->getType() != NodeType::MODULE) return module;
+        std::unordered_set<std::string>& functionNames = context.getFunctionNames();
         const std::string moduleName = module->getData().asString();
         for(const auto& subnode : module->getSubnodes()) {
             NodeType ty = subnode->getType();
@@ -41,6 +59,8 @@ namespace nvyc::Passes {
                     nvyc::Error::nvyerr_failcompile(1, "Duplicate function definition found for " + prototype);
                 }
                 functionNames.insert(newName);
+                context.getFunctionAliases()[currentName].push_back(newName);
+                recordExport(context, *subnode, currentName, newName);
                 subnode->setValue(Value(newName));
             }
         }
@@ -83,4 +103,247 @@ namespace nvyc::Passes {
         
     }
 
-}
\ No newline at end of file
+
+
+    // ----------------------------------------
+    //            CONSTANT FOLDING
+    // ----------------------------------------
+
+    // Only these literals carry their value in the matching Value member, STR/CHAR/SHORT are left for the emitter to reject
+    static bool isFoldable(NodeType type) {
+        return type == NodeType::INT32 || type == NodeType::INT64 || type == NodeType::FP32 || type == NodeType::FP64;
+    }
+
+    /*
+        Folds literal subtrees and integer identities before emission
+
+        Node(VARDEF, y)                     Node(VARDEF, y)
+        -- Node(ADD, VOID)          ->      -- Node(INT32, 3)
+           -- Node(INT32, 1)
+           -- Node(INT32, 2)
+
+        Result types follow the same promotion as EmissionBuilder::arithmeticPrecedence,
+        so a folded literal has the type the emitter would have produced.
+    */
+    std::unique_ptr<NASTNode> foldConstants(std::unique_ptr<NASTNode> node) {
+        TypeScope scope;
+        foldNode(node, scope);
+        return node;
+    }
+
+    void foldNode(std::unique_ptr<NASTNode>& node, TypeScope& scope) {
+        if(!node) return;
+        NodeType ty = node->getType();
+
+        if(symbols::isArithmetic(ty)) {
+            foldExpression(node, scope);
+            return;
+        }
+
+        // Variables are only known within their function, parameters are typed up front
+        if(ty == NodeType::FUNCTION) {
+            scope.clear();
+            for(const auto& paramNode : node->getSubnode(0)->getSubnodes()) {
+                scope[paramNode->getData().asString()] = symbols::declaredToLiteral(paramNode->getType());
+            }
+        }
+
+        for(auto& subnode : node->getSubnodes()) {
+            foldNode(subnode, scope);
+        }
+
+        if(ty == NodeType::VARDEF && !node->getSubnodes().empty()) {
+            scope[node->getData().asString()] = foldExpression(node->getSubnodes()[0], scope);
+        }
+    }
+
+    // Returns the static type of the expression, or INVALID if it can't be known before emission
+    NodeType foldExpression(std::unique_ptr<NASTNode>& node, TypeScope& scope) {
+        NodeType ty = node->getType();
+
+        if(symbols::isLiteral(ty)) return ty;
+
+        if(ty == NodeType::VARIABLE) {
+            auto it = scope.find(node->getData().asString());
+            if(it == scope.end() || !node->getSubnodes().empty()) return NodeType::INVALID;
+            return it->second;
+        }
+
+        if(!symbols::isArithmetic(ty) || node->getSubnodes().size() != 2) {
+            for(auto& subnode : node->getSubnodes()) {
+                foldNode(subnode, scope);
+            }
+            return NodeType::INVALID;
+        }
+
+        std::vector<std::unique_ptr<NASTNode>>& operands = node->getSubnodes();
+        NodeType lhsType = foldExpression(operands[0], scope);
+        NodeType rhsType = foldExpression(operands[1], scope);
+
+        NodeType resultType = NodeType::INVALID;
+        if(isFoldable(lhsType) && isFoldable(rhsType)) {
+            resultType = symbols::promoteNumeric(symbols::promoteNumeric(NodeType::INT32, lhsType), rhsType);
+        }
+
+        if(isFoldable(operands[0]->getType()) && isFoldable(operands[1]->getType())) {
+            auto folded = foldLiterals(ty, operands[0].get(), operands[1].get());
+            if(folded) {
+                node = std::move(folded);
+                return node->getType();
+            }
+            return resultType;
+        }
+
+        simplifyIdentity(node, lhsType, rhsType, resultType);
+        return resultType;
+    }
+
+    std::unique_ptr<NASTNode> foldLiterals(NodeType op, const NASTNode* lhs, const NASTNode* rhs) {
+        if(!isFoldable(lhs->getType()) || !isFoldable(rhs->getType())) return nullptr;
+
+        NodeType resultType = symbols::promoteNumeric(symbols::promoteNumeric(NodeType::INT32, lhs->getType()), rhs->getType());
+        const Value lv = lhs->getData();
+        const Value rv = rhs->getData();
+
+        auto asInt = [](const Value& v) -> int64_t {
+            return v.type == NodeType::INT64 ? v.i64 : v.i32;
+        };
+
+        auto asFloat = [](const Value& v) -> double {
+            switch(v.type) {
+                case NodeType::INT32: return v.i32;
+                case NodeType::INT64: return static_cast<double>(v.i64);
+                case NodeType::FP32:  return v.f32;
+                default:              return v.f64;
+            }
+        };
+
+        switch(resultType) {
+            case NodeType::INT32:
+            case NodeType::INT64: {
+                bool wide = resultType == NodeType::INT64;
+                int64_t a = asInt(lv);
+                int64_t b = asInt(rv);
+                int64_t min = wide ? INT64_MIN : INT32_MIN;
+                uint64_t result;
+
+                // Wrapping semantics match the emitted add/sub/mul
+                switch(op) {
+                    case NodeType::ADD: result = uint64_t(a) + uint64_t(b); break;
+                    case NodeType::SUB: result = uint64_t(a) - uint64_t(b); break;
+                    case NodeType::MUL: result = uint64_t(a) * uint64_t(b); break;
+                    case NodeType::DIV:
+                        // Leave traps to runtime
+                        if(b == 0 || (a == min && b == -1)) return nullptr;
+                        result = uint64_t(a / b);
+                        break;
+                    default: return nullptr;
+                }
+
+                if(wide) return nvyc::ParserUtils::createNode(NodeType::INT64, Value(int64_t(result)));
+                return nvyc::ParserUtils::createNode(NodeType::INT32, Value(int32_t(uint32_t(result))));
+            }
+
+            case NodeType::FP32: {
+                float a = float(asFloat(lv));
+                float b = float(asFloat(rv));
+                float result;
+
+                switch(op) {
+                    case NodeType::ADD: result = a + b; break;
+                    case NodeType::SUB: result = a - b; break;
+                    case NodeType::MUL: result = a * b; break;
+                    case NodeType::DIV: result = a / b; break;
+                    default: return nullptr;
+                }
+
+                return nvyc::ParserUtils::createNode(NodeType::FP32, Value(result));
+            }
+
+            case NodeType::FP64: {
+                double a = asFloat(lv);
+                double b = asFloat(rv);
+                double result;
+
+                switch(op) {
+                    case NodeType::ADD: result = a + b; break;
+                    case NodeType::SUB: result = a - b; break;
+                    case NodeType::MUL: result = a * b; break;
+                    case NodeType::DIV: result = a / b; break;
+                    default: return nullptr;
+                }
+
+                return nvyc::ParserUtils::createNode(NodeType::FP64, Value(result));
+            }
+
+            default:
+                return nullptr;
+        }
+    }
+
+    /*
+        x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1  ->  x
+        x * 0, 0 * x                              ->  0
+
+        Integer only, since none of these hold for floats (-0.0, NaN). The
+        remaining operand must already have the result type, otherwise
+        dropping the operation would also drop a promotion.
+    */
+    void simplifyIdentity(std::unique_ptr<NASTNode>& node, NodeType lhsType, NodeType rhsType, NodeType resultType) {
+        if(resultType != NodeType::INT32 && resultType != NodeType::INT64) return;
+
+        NodeType op = node->getType();
+        std::vector<std::unique_ptr<NASTNode>>& operands = node->getSubnodes();
+
+        auto isConstant = [](const NASTNode* n, int64_t value) {
+            const Value v = n->getData();
+            if(n->getType() == NodeType::INT32) return v.i32 == value;
+            if(n->getType() == NodeType::INT64) return v.i64 == value;
+            return false;
+        };
+
+        // Keep one operand in place of the whole node
+        auto keep = [&](int side) {
+            auto operand = std::move(operands[side]);
+            node = std::move(operand);
+        };
+
+        bool lhsExact = lhsType == resultType;
+        bool rhsExact = rhsType == resultType;
+
+        switch(op) {
+            case NodeType::ADD:
+                if(isConstant(operands[1].get(), 0) && lhsExact) keep(0);
+                else if(isConstant(operands[0].get(), 0) && rhsExact) keep(1);
+                break;
+            case NodeType::SUB:
+                if(isConstant(operands[1].get(), 0) && lhsExact) keep(0);
+                break;
+            case NodeType::MUL:
+                if(isConstant(operands[1].get(), 1) && lhsExact) keep(0);
+                else if(isConstant(operands[0].get(), 1) && rhsExact) keep(1);
+                else if(
+                    (isConstant(operands[0].get(), 0) && !hasSideEffects(operands[1].get())) ||
+                    (isConstant(operands[1].get(), 0) && !hasSideEffects(operands[0].get()))
+                ) {
+                    if(resultType == NodeType::INT64) node = nvyc::ParserUtils::createNode(NodeType::INT64, Value(int64_t(0)));
+                    else node = nvyc::ParserUtils::createNode(NodeType::INT32, Value(int32_t(0)));
+                }
+                break;
+            case NodeType::DIV:
+                if(isConstant(operands[1].get(), 1) && lhsExact) keep(0);
+                break;
+            default:
+                break;
+        }
+    }
+
+    bool hasSideEffects(const NASTNode* node) {
+        if(node->getType() == NodeType::FUNCTIONCALL) return true;
+        for(const auto& subnode : node->getSubnodes()) {
+            if(subnode && hasSideEffects(subnode.get())) return true;
+        }
+        return false;
+    }
+
+}
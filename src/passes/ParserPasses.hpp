@@ -2,15 +2,27 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include "data/NodeType.hpp"
 #include "data/NASTNode.hpp"
+#include "utils/CompilationContext.hpp"
 
 using nvyc::NodeType;
 
 namespace nvyc::Passes {
 
-    std::unique_ptr<NASTNode> mangleFunctions(std::unique_ptr<NASTNode> module);
+    std::unique_ptr<NASTNode> mangleFunctions(CompilationContext& context, std::unique_ptr<NASTNode> module);
     std::string mangleFunction(const std::string& moduleName, const std::string& functionName, std::vector<NodeType>& args, std::vector<std::string>& names);
     std::string resolveFunctionCall(const NASTNode* node);
 
+    // Constant folding
+    using TypeScope = std::unordered_map<std::string, NodeType>;
+
+    std::unique_ptr<NASTNode> foldConstants(std::unique_ptr<NASTNode> node);
+    void foldNode(std::unique_ptr<NASTNode>& node, TypeScope& scope);
+    NodeType foldExpression(std::unique_ptr<NASTNode>& node, TypeScope& scope);
+    std::unique_ptr<NASTNode> foldLiterals(NodeType op, const NASTNode* lhs, const NASTNode* rhs);
+    void simplifyIdentity(std::unique_ptr<NASTNode>& node, NodeType lhsType, NodeType rhsType, NodeType resultType);
+    bool hasSideEffects(const NASTNode* node);
+
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "data/NodeStream.hpp"
 #include "data/NASTNode.hpp"
 #include "ParserPasses.hpp"
+#include "CompilationPasses.hpp"
 #include <vector>
 #include <memory>
 
@@ -13,17 +14,39 @@ using nvyc::NASTNode;
 namespace nvyc::Passes {
 
     bool PassManager::executeLexicalPasses(NodeStream& stream) {
-        return 0;
+        auto scope = context.getStats().time("lexicalPasses");
+        StreamValidationPass svp(rebuilder);
+        return runPass("validTokens", [&] { return svp.validTokens(stream); });
     }
 
     std::unique_ptr<NASTNode> PassManager::executeParsingPasses(std::unique_ptr<NASTNode> node) {
-        node = nvyc::Passes::mangleFunctions(std::move(node));
+        auto scope = context.getStats().time("parsingPasses");
+        node = runPass("mangleFunctions", [&] { return nvyc::Passes::mangleFunctions(context, std::move(node)); });
+        node = runPass("foldConstants", [&] { return nvyc::Passes::foldConstants(std::move(node)); });
         return node;
     }
 
     bool PassManager::executeCompilationPasses(std::vector<std::unique_ptr<NASTNode>>& nodes) {
+        auto scope = context.getStats().time("compilationPasses");
+        runPass("eliminateDeadFunctions", [&] { return nvyc::Passes::eliminateDeadFunctions(context, nodes); });
+        runPass("annotateTypes", [&] { return nvyc::Passes::annotateTypes(context, nodes); });
         return 0;
     }
 
+    /*
+        Streaming compile: everything that works on one declaration at a time.
+        Dead function elimination needs the whole program, so it is skipped
+        and left to LLVM's GlobalDCE in the optimized pipelines.
+    */
+    std::unique_ptr<NASTNode> PassManager::executeDeclarationPasses(std::unique_ptr<NASTNode> node) {
+        node = executeParsingPasses(std::move(node));
+
+        auto scope = context.getStats().time("compilationPasses");
+        std::vector<std::unique_ptr<NASTNode>> nodes;
+        nodes.push_back(std::move(node));
+        runPass("annotateTypes", [&] { return nvyc::Passes::annotateTypes(context, nodes); });
+        return std::move(nodes.front());
+    }
+
     
 }
\ No newline at end of file
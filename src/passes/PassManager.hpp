@@ -4,6 +4,7 @@
 #include "data/NASTNode.hpp"
 #include "StreamValidationPass.hpp"
 #include "processing/StreamRebuilder.hpp"
+#include "utils/CompilationContext.hpp"
 #include <vector>
 #include <string>
 #include <memory>
@@ -15,9 +16,17 @@ namespace nvyc::Passes {
 
     class PassManager {
         private:
+            CompilationContext& context;
             nvyc::Processing::StreamRebuilder& rebuilder;
             //nvyc::Passes::StreamValidationPass svp(rebuilder);
 
+            // Every pass goes through here so -ftime-report picks it up without extra bookkeeping
+            template <typename F>
+            auto runPass(const std::string& name, F&& pass) -> decltype(pass()) {
+                auto scope = context.getStats().time(name);
+                return pass();
+            }
+
             // Lexical
 
             // Parser
@@ -25,10 +34,11 @@ namespace nvyc::Passes {
             // Compilation
 
         public:
-            PassManager(nvyc::Processing::StreamRebuilder& rb) : rebuilder(rb) {};
+            PassManager(CompilationContext& ctx, nvyc::Processing::StreamRebuilder& rb) : context(ctx), rebuilder(rb) {};
 
             bool executeLexicalPasses(NodeStream& stream);
             std::unique_ptr<NASTNode> executeParsingPasses(std::unique_ptr<NASTNode> node);
             bool executeCompilationPasses(std::vector<std::unique_ptr<NASTNode>>& nodes);
+            std::unique_ptr<NASTNode> executeDeclarationPasses(std::unique_ptr<NASTNode> node);
     };
 }
\ No newline at end of file
@@ -34,7 +34,7 @@ namespace nvyc::Passes {
             
             
             // '->' must always be followed by a type
-            if(ty == NodeType::RETTYPE && !nvyc::symbols::TYPE_SYMBOLS.count(nextTy)) {
+            if(ty == NodeType::RETTYPE && !nvyc::symbols::isTypeSymbol(nextTy)) {
                 std::cout << symbols::nodeTypeToString(ty) << " " << symbols::nodeTypeToString(nextTy) << std::endl;
                 ss << it.peek(1).getLine() << ".\n" << "Missing return type after '->'\n";
                 ss << rebuilder.getErrorLocation(it.peek(1).getLine()-1, index);
@@ -46,7 +46,7 @@ namespace nvyc::Passes {
             else if(
                 ty == NodeType::ENDOFLINE && 
                 (
-                    !nvyc::symbols::START_SYMBOLS.count(nextTy) &&
+                    !nvyc::symbols::isStartSymbol(nextTy) &&
                     nextTy != NodeType::CLOSEBRACE
                 )) {
                 ss << it.peek(1).getLine() << ".\n" << "Token after ';' is not the start of a statement\n";
@@ -64,13 +64,13 @@ namespace nvyc::Passes {
 
                 // If we have a start symbols (let, return, etc) and the previous symbol was not EOL/blocking
                 if(
-                    symbols::START_SYMBOLS.count(ty) && 
+                    symbols::isStartSymbol(ty) && 
                     (
                         (
                             it.behind(1).getType() != NodeType::ENDOFLINE &&
-                            !symbols::BRACES.count(it.behind(1).getType())
+                            !symbols::isBrace(it.behind(1).getType())
                         ) &&
-                        !symbols::START_SYMBOLS.count(it.behind(1).getType())
+                        !symbols::isStartSymbol(it.behind(1).getType())
                     )
                 ) {
                     ss << it.behind(1).getLine() << ".\n" << "Missing semicolon\n";
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "data/NodeType.hpp"
+#include "error/Debug.hpp"
+#include "utils/CompileStats.hpp"
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Per-compilation state. Anything that used to be a file-scope global in
+        the Lexer/Parser/passes lives here instead, so each module can be
+        compiled on its own thread with its own context.
+    */
+    class CompilationContext {
+        private:
+            std::string moduleName;
+            DebugState debugState;
+            CompileStats stats;
+
+            // Parser
+            bool nativeFunction = false;
+
+            // Passes
+            std::unordered_set<std::string> functionNames;
+            std::unordered_map<std::string, std::vector<std::string>> functionAliases;
+            std::unordered_set<std::string> entryPoints;
+            std::unordered_set<std::string> exportedFunctions;
+            std::unordered_map<std::string, NodeType> functionReturnTypes;
+
+        public:
+            CompilationContext(const std::string& name) : moduleName(name) {}
+
+            // Contexts are tied to a single compilation
+            CompilationContext(const CompilationContext&) = delete;
+            CompilationContext& operator=(const CompilationContext&) = delete;
+
+            const std::string& getModuleName() const {
+                return moduleName;
+            }
+
+            DebugState& getDebug() {
+                return debugState;
+            }
+
+            CompileStats& getStats() {
+                return stats;
+            }
+
+            bool isNativeFunction() const {
+                return nativeFunction;
+            }
+
+            void setNativeFunction(bool native) {
+                nativeFunction = native;
+            }
+
+            std::unordered_set<std::string>& getFunctionNames() {
+                return functionNames;
+            }
+
+            // Source name -> every mangled name it was given
+            std::unordered_map<std::string, std::vector<std::string>>& getFunctionAliases() {
+                return functionAliases;
+            }
+
+            // Functions kept alive besides main, by source or mangled name
+            std::unordered_set<std::string>& getEntryPoints() {
+                return entryPoints;
+            }
+
+            // Mangled names that keep external linkage and the C calling convention, filled by mangleFunctions
+            std::unordered_set<std::string>& getExportedFunctions() {
+                return exportedFunctions;
+            }
+
+            // Mangled name -> literal return type, filled by annotateTypes as declarations are seen
+            std::unordered_map<std::string, NodeType>& getFunctionReturnTypes() {
+                return functionReturnTypes;
+            }
+
+    }; // class CompilationContext
+} // namespace nvyc
@@ -2,10 +2,24 @@
 
 #include "error/Debug.hpp"
 #include "error/Error.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace nvyc {
+
+    enum class OptLevel {
+        O0, O1, O2, O3, Os, Oz
+    };
+
+    enum class LTOMode {
+        NONE, FULL, THIN
+    };
+
     class CompileOptions {
         private:
             bool debug = false;
@@ -13,6 +27,32 @@ namespace nvyc {
             bool emit_ll = false;
             bool emit_o = false;
             bool emit_asm = false;
+            bool emit_archive = false;
+            OptLevel opt_level = OptLevel::O0;
+            unsigned int jobs = 1;
+            LTOMode lto = LTOMode::NONE;
+            std::string target_cpu = "generic";
+            std::string target_features;
+            bool profile_generate = false;
+            std::string profile_generate_file;
+            std::string profile_use_file;
+            bool time_report = false;
+            bool time_report_json = false;
+            bool stats = false;
+            bool perf_counters = false;
+            bool mem_report = false;
+            bool stream_lex = false;
+            bool stream_lex_threaded = false;
+            bool stream_compile = false;
+            bool time_trace = false;
+            std::string time_trace_file;
+            bool run = false;
+            bool repl = false;
+            bool lazy_jit = true;
+            bool jit_cache = true;
+            std::string jit_cache_dir;
+            uint64_t jit_cache_size = 256ull << 20;
+            std::vector<std::string> runArgs;
             std::vector<std::string> inputFiles;
             std::string outputFile;
             char** options;
@@ -25,6 +65,12 @@ namespace nvyc {
                 for(int i = 1; i < argCount; i++) {
                     std::string val = options[i];
 
+                    // nvyc -run file.nvy [args], everything after the input belongs to the program
+                    if(run && !inputFiles.empty()) {
+                        runArgs.push_back(val);
+                        continue;
+                    }
+
                     if(val == "-o") {
                         if(i + 1 < argCount) {
                             outputFile = options[i+1];
@@ -36,13 +82,91 @@ namespace nvyc {
                     else if(val == "-emit-ll") emit_ll = true;
                     else if(val == "-emit-o") emit_o = true;
                     else if(val == "-emit-S") emit_asm = true;
+                    else if(val == "-emit-a") emit_archive = true;
+                    else if(val == "--repl") repl = true;
+                    else if(val == "-run") run = true;
+                    else if(val == "-run=eager") {
+                        run = true;
+                        lazy_jit = false;
+                    }
+                    else if(val == "-fno-jit-cache") jit_cache = false;
+                    else if(val.starts_with("-fjit-cache=")) {
+                        jit_cache = true;
+                        jit_cache_dir = val.substr(12);
+                    }
+                    else if(val.starts_with("-fjit-cache-size=")) jit_cache_size = std::strtoull(val.c_str() + 17, nullptr, 10) << 20;
+                    else if(val == "-O0") opt_level = OptLevel::O0;
+                    else if(val == "-O1") opt_level = OptLevel::O1;
+                    else if(val == "-O2") opt_level = OptLevel::O2;
+                    else if(val == "-O3") opt_level = OptLevel::O3;
+                    else if(val == "-Os") opt_level = OptLevel::Os;
+                    else if(val == "-Oz") opt_level = OptLevel::Oz;
+                    else if(val.starts_with("-O")) nvyc::Error::nvyerr_failcompile(1, "Unknown optimization level " + val + ". Please use -O0 through -O3, -Os or -Oz");
+
+                    // -j alone uses every hardware thread, -j N / -jN picks the count
+                    else if(val == "-j" && (i + 1 >= argCount || !std::isdigit((unsigned char) options[i+1][0]))) {
+                        jobs = std::max(1u, std::thread::hardware_concurrency());
+                    }
+                    else if(val == "-j") {
+                        jobs = std::max(1, std::atoi(options[i+1]));
+                        i++;
+                    }
+                    else if(val.starts_with("-j")) jobs = std::max(1, std::atoi(val.c_str() + 2));
+
+                    // -march and -mcpu both pick the CPU, "native" is resolved against the host by EmissionBuilder::setTarget
+                    else if(val.starts_with("-march=")) target_cpu = val.substr(7);
+                    else if(val.starts_with("-mcpu=")) target_cpu = val.substr(6);
+                    else if(val.starts_with("-mattr=")) target_features = val.substr(7);
+
+                    else if(val == "-flto" || val == "-flto=full") lto = LTOMode::FULL;
+                    else if(val == "-flto=thin") lto = LTOMode::THIN;
+                    else if(val.starts_with("-flto=")) nvyc::Error::nvyerr_failcompile(1, "Unknown LTO mode " + val + ". Please use -flto=full or -flto=thin");
+
+                    else if(val == "-fprofile-generate") profile_generate = true;
+                    else if(val.starts_with("-fprofile-generate=")) {
+                        profile_generate = true;
+                        profile_generate_file = val.substr(19);
+                    }
+                    else if(val.starts_with("-fprofile-use=")) profile_use_file = val.substr(14);
+                    else if(val == "-fprofile-use") nvyc::Error::nvyerr_failcompile(1, "Profile not provided. Please use -fprofile-use=<file.profdata>");
+
+                    else if(val == "-ftime-report") time_report = true;
+                    else if(val == "-ftime-report=json") time_report = time_report_json = true;
+                    else if(val == "-stats") stats = true;
+                    else if(val == "-fperf-counters") perf_counters = true;
+                    else if(val == "-fmem-report") mem_report = true;
+                    else if(val == "-fstream-lex") stream_lex = true;
+                    else if(val == "-fstream-lex=threaded") stream_lex = stream_lex_threaded = true;
+                    else if(val == "-fstream-compile") stream_lex = stream_compile = true;
+                    else if(val == "-ftime-trace") time_trace = true;
+                    else if(val.starts_with("-ftime-trace=")) {
+                        time_trace = true;
+                        time_trace_file = val.substr(13);
+                    }
+
                     else if(val.starts_with("-debug")) {
-                        nvyc::enable_debugging(9);
+                        debug_flags = 9;
                         debug = true;
                     }
 
                     else inputFiles.push_back(options[i]);
                 }
+
+                // Counters are found through linker-defined section bounds, which the JIT never creates
+                if(profile_generate && (run || repl)) {
+                    nvyc::Error::nvyerr_failcompile(1, "-fprofile-generate needs a linked executable and can't be used with -run or --repl");
+                }
+                if(profile_generate && !profile_use_file.empty()) {
+                    nvyc::Error::nvyerr_failcompile(1, "-fprofile-generate and -fprofile-use can't be combined");
+                }
+                // ThinLTO generates code per module, one object can't hold more than one of them
+                if(lto == LTOMode::THIN && inputFiles.size() > 1 && !emit_archive) {
+                    nvyc::Error::nvyerr_failcompile(1, "-flto=thin writes one object per input. Please add -emit-a to get them as an archive, or use -flto=full");
+                }
+                // Partitions can't be merged back into one object in process, so -j only splits codegen for -emit-a
+                if(jobs > 1 && (emit_o || emit_asm) && !emit_archive) {
+                    nvyc::Error::nvyerr_failcompile(1, "-j splits codegen into one object per partition. Please use -emit-a to get them as an archive, -emit-o and -emit-S are always compiled on one thread");
+                }
             }
 
             bool get_emit_ll() {
@@ -57,14 +181,140 @@ namespace nvyc {
                 return debug;
             }
 
+            unsigned int get_debug_flags() {
+                return debug_flags;
+            }
+
             bool get_emit_S() {
                 return emit_asm;
             }
 
+            // ar archive of one object per codegen partition, the only output -j splits codegen for
+            bool get_emit_a() {
+                return emit_archive;
+            }
+
+            OptLevel get_opt_level() {
+                return opt_level;
+            }
+
+            // Codegen threads for -emit-a, the module is split into this many partitions. -emit-o is always one object
+            unsigned int get_jobs() {
+                return jobs;
+            }
+
+            std::string& get_target_cpu() {
+                return target_cpu;
+            }
+
+            // LLVM feature string, e.g. +avx2,-avx512f
+            std::string& get_target_features() {
+                return target_features;
+            }
+
+            // Every input is emitted as bitcode and optimized together by LTOLinker before codegen
+            LTOMode get_lto() {
+                return lto;
+            }
+
+            // Instrumented build, link with the compiler-rt profile runtime (clang -fprofile-generate)
+            bool get_profile_generate() {
+                return profile_generate;
+            }
+
+            // Where the instrumented program writes its .profraw, empty means default_%m.profraw or $LLVM_PROFILE_FILE
+            std::string& get_profile_generate_file() {
+                return profile_generate_file;
+            }
+
+            // Merged profile (llvm-profdata merge) to optimize with, empty if none
+            std::string& get_profile_use_file() {
+                return profile_use_file;
+            }
+
+            bool get_time_report() {
+                return time_report;
+            }
+
+            bool get_time_report_json() {
+                return time_report_json;
+            }
+
+            bool get_stats() {
+                return stats;
+            }
+
+            // Implies -ftime-report, falls back to timing only if the counters can't be opened
+            bool get_perf_counters() {
+                return perf_counters;
+            }
+
+            // Reported in the same format as -ftime-report (text or json)
+            bool get_mem_report() {
+                return mem_report;
+            }
+
+            // Lex one declaration at a time through LexerStream, optionally on a producer thread
+            bool get_stream_lex() {
+                return stream_lex;
+            }
+
+            bool get_stream_lex_threaded() {
+                return stream_lex_threaded;
+            }
+
+            // Parse, emit and free one declaration at a time (compileStream), implies -fstream-lex
+            bool get_stream_compile() {
+                return stream_compile;
+            }
+
+            bool get_time_trace() {
+                return time_trace;
+            }
+
+            // Empty means next to the output, as <output>.time-trace
+            std::string& get_time_trace_file() {
+                return time_trace_file;
+            }
+
             std::string& getOutput() {
                 return outputFile;
             }
 
+            // JIT main in-process instead of writing output
+            bool get_run() {
+                return run;
+            }
+
+            // Interactive session, entries are compiled into the same JIT as -run (and share its flags)
+            bool get_repl() {
+                return repl;
+            }
+
+            // LLLazyJIT unless -run=eager
+            bool get_lazy_jit() {
+                return lazy_jit;
+            }
+
+            // Object cache for -run, on by default, -fno-jit-cache turns it off
+            bool get_jit_cache() {
+                return jit_cache;
+            }
+
+            // Empty means JITObjectCache::defaultDirectory()
+            std::string& get_jit_cache_dir() {
+                return jit_cache_dir;
+            }
+
+            // Bytes, from -fjit-cache-size=<MiB>
+            uint64_t get_jit_cache_size() {
+                return jit_cache_size;
+            }
+
+            std::vector<std::string>& getRunArgs() {
+                return runArgs;
+            }
+
             std::vector<std::string>& getInput() {
                 return inputFiles;
             }
@@ -0,0 +1,310 @@
+#include "CompileStats.hpp"
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <llvm/Support/TimeProfiler.h>
+
+namespace nvyc {
+
+    // ----------------------------------------
+    //                 SCOPE
+    // ----------------------------------------
+
+    CompileStats::Scope::Scope(CompileStats* s, const std::string& name) : stats(s), traced(false), index(0), cpuStart(0) {
+        if(llvm::timeTraceProfilerEnabled()) {
+            llvm::timeTraceProfilerBegin(name, "");
+            traced = true;
+        }
+
+        if(!stats) return;
+
+        index = stats->beginPhase(name);
+        wallStart = std::chrono::steady_clock::now();
+        cpuStart = threadCpuMs();
+        perfStart = stats->perf.read();
+        memoryStart = MemoryStats::threadSample();
+    }
+
+    CompileStats::Scope::Scope(Scope&& other) noexcept
+        : stats(other.stats), traced(other.traced), index(other.index), wallStart(other.wallStart), cpuStart(other.cpuStart), perfStart(other.perfStart), memoryStart(other.memoryStart) {
+        other.stats = nullptr;
+        other.traced = false;
+    }
+
+    CompileStats::Scope::~Scope() {
+        if(traced) llvm::timeTraceProfilerEnd();
+        if(!stats) return;
+
+        MemoryStats::Sample memoryEnd = MemoryStats::threadSample();
+        PerfSample perfEnd = stats->perf.read();
+        double cpuEnd = threadCpuMs();
+        auto wallEnd = std::chrono::steady_clock::now();
+        Phase& phase = stats->phases[index];
+        phase.wallMs += std::chrono::duration<double, std::milli>(wallEnd - wallStart).count();
+        phase.cpuMs += cpuEnd - cpuStart;
+        phase.count++;
+        if(stats->perf.available()) phase.perf += perfEnd - perfStart;
+        phase.memory += memoryEnd - memoryStart;
+        stats->open.pop_back();
+    }
+
+
+    // ----------------------------------------
+    //              COLLECTION
+    // ----------------------------------------
+
+    void CompileStats::enableTiming(Format fmt) {
+        timing = true;
+        format = fmt;
+    }
+
+    void CompileStats::enableCounters() {
+        counting = true;
+    }
+
+    /*
+        Counters are only read at phase boundaries, so -fperf-counters implies timing.
+        On failure the caller reports the reason and the compile keeps timing only
+    */
+    bool CompileStats::enablePerfCounters(std::string& error) {
+        if(!timing) enableTiming(format);
+        return perf.open(error);
+    }
+
+    // Same as the counters, memory is sampled per phase so it implies timing
+    void CompileStats::enableMemory() {
+        if(!timing) enableTiming(format);
+        memory = true;
+        MemoryStats::enableCounting();
+    }
+
+    bool CompileStats::timingEnabled() const {
+        return timing;
+    }
+
+    bool CompileStats::countersEnabled() const {
+        return counting;
+    }
+
+    bool CompileStats::perfCountersEnabled() const {
+        return perf.available();
+    }
+
+    bool CompileStats::memoryEnabled() const {
+        return memory;
+    }
+
+    CompileStats::Scope CompileStats::time(const std::string& name) {
+        return Scope(timing ? this : nullptr, name);
+    }
+
+    /*
+        Repeated phases under the same parent (a pass run once per module, say)
+        accumulate into a single row instead of adding one per call
+    */
+    size_t CompileStats::beginPhase(const std::string& name) {
+        int depth = open.size();
+        size_t first = open.empty() ? 0 : open.back() + 1;
+
+        for(size_t i = first; i < phases.size(); i++) {
+            if(phases[i].depth < depth) break;
+            if(phases[i].depth == depth && phases[i].name == name) {
+                open.push_back(i);
+                return i;
+            }
+        }
+
+        phases.push_back(Phase{name, depth, 0, 0, 0, PerfSample(), MemoryStats::Sample()});
+        open.push_back(phases.size() - 1);
+        return phases.size() - 1;
+    }
+
+    void CompileStats::addCounter(const std::string& name, uint64_t value) {
+        if(!counting && !timing) return;
+
+        for(auto& counter : counters) {
+            if(counter.first == name) {
+                counter.second += value;
+                return;
+            }
+        }
+        counters.emplace_back(name, value);
+    }
+
+    void CompileStats::addStructure(const std::string& name, const MemoryUsage& usage) {
+        if(!memory) return;
+
+        for(auto& structure : structures) {
+            if(structure.first == name) {
+                structure.second += usage;
+                return;
+            }
+        }
+        structures.emplace_back(name, usage);
+    }
+
+    const std::vector<CompileStats::Phase>& CompileStats::getPhases() const {
+        return phases;
+    }
+
+    const std::vector<std::pair<std::string, uint64_t>>& CompileStats::getCounters() const {
+        return counters;
+    }
+
+    // CPU time of the calling thread, so parallel compiles don't see each other's work
+    double CompileStats::threadCpuMs() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#else
+        return 1000.0 * std::clock() / CLOCKS_PER_SEC;
+#endif
+    }
+
+    double CompileStats::scalingExponent(const std::vector<std::pair<double, double>>& points) {
+        double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for(const auto& point : points) {
+            if(point.first <= 0 || point.second <= 0) continue;
+            double x = std::log(point.first), y = std::log(point.second);
+            n++; sx += x; sy += y; sxx += x * x; sxy += x * y;
+        }
+
+        double denom = n * sxx - sx * sx;
+        return (n < 2 || denom == 0) ? 0 : (n * sxy - sx * sy) / denom;
+    }
+
+
+    // ----------------------------------------
+    //               REPORTING
+    // ----------------------------------------
+
+    void CompileStats::report(std::ostream& os) const {
+        if(format == Format::JSON) reportJson(os);
+        else reportText(os);
+    }
+
+    /*
+        ===== nvyc time report =====
+        Phase                          Wall (ms)     CPU (ms)    Calls
+        lex                                0.412        0.410        1
+        parsingPasses                      1.050        1.049        3
+          mangleFunctions                  0.120        0.120        3
+
+        With -fperf-counters each row also gets cycles, IPC and the cache/branch miss rates
+    */
+    void CompileStats::reportText(std::ostream& os) const {
+        if(!phases.empty()) reportPhases(os);
+        if(memory) reportMemory(os);
+
+        if(!counters.empty()) {
+            os << "\n===== nvyc statistics =====\n";
+            for(const auto& counter : counters) {
+                os << std::left << std::setw(32) << counter.first << std::right << std::setw(12) << counter.second << "\n";
+            }
+        }
+    }
+
+    void CompileStats::reportPhases(std::ostream& os) const {
+        bool counted = perf.available();
+
+        os << "===== nvyc time report =====\n";
+        os << std::left << std::setw(32) << "Phase" << std::right << std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)" << std::setw(9) << "Calls";
+        if(counted) os << std::setw(14) << "Cycles" << std::setw(8) << "IPC" << std::setw(10) << "Cache %" << std::setw(10) << "Branch %";
+        os << "\n";
+        os << std::fixed << std::setprecision(3);
+
+        for(const Phase& phase : phases) {
+            std::string label = std::string(phase.depth * 2, ' ') + phase.name;
+            os << std::left << std::setw(32) << label << std::right << std::setw(12) << phase.wallMs << std::setw(12) << phase.cpuMs << std::setw(9) << phase.count;
+            if(counted) {
+                os << std::setw(14) << phase.perf.cycles << std::setprecision(2) << std::setw(8) << phase.perf.ipc()
+                   << std::setw(10) << phase.perf.cacheMissRate() * 100 << std::setw(10) << phase.perf.branchMissRate() * 100 << std::setprecision(3);
+            }
+            os << "\n";
+        }
+
+        os.unsetf(std::ios::floatfield);
+    }
+
+    /*
+        ===== nvyc memory report =====
+        Phase                               Allocs   Alloc (KB)    Live (KB)
+        lex                                   1840       96.250       41.125
+        ...
+        Structure                           Allocs   Bytes (KB)
+        NodeStream tokens                        1       40.000
+        Peak RSS (KB)                                   18432
+    */
+    void CompileStats::reportMemory(std::ostream& os) const {
+        os << "\n===== nvyc memory report =====\n";
+        os << std::left << std::setw(32) << "Phase" << std::right << std::setw(10) << "Allocs" << std::setw(13) << "Alloc (KB)" << std::setw(13) << "Live (KB)" << "\n";
+        os << std::fixed << std::setprecision(3);
+        if(!MemoryStats::hooksLinked()) os << "(allocation hooks not linked in, per-phase counts unavailable)\n";
+
+        for(const Phase& phase : phases) {
+            std::string label = std::string(phase.depth * 2, ' ') + phase.name;
+            os << std::left << std::setw(32) << label << std::right << std::setw(10) << phase.memory.allocations
+               << std::setw(13) << phase.memory.allocatedBytes / 1024.0 << std::setw(13) << phase.memory.liveBytes / 1024.0 << "\n";
+        }
+
+        if(!structures.empty()) {
+            os << "\n" << std::left << std::setw(32) << "Structure" << std::right << std::setw(10) << "Allocs" << std::setw(13) << "Bytes (KB)" << "\n";
+            for(const auto& structure : structures) {
+                os << std::left << std::setw(32) << structure.first << std::right << std::setw(10) << structure.second.allocations
+                   << std::setw(13) << structure.second.bytes / 1024.0 << "\n";
+            }
+        }
+
+        os.unsetf(std::ios::floatfield);
+        os << "\n" << std::left << std::setw(32) << "Peak RSS (KB)" << std::right << std::setw(23) << MemoryStats::peakRssBytes() / 1024 << "\n";
+    }
+
+    /*
+        Stable schema: {"phases": [{"name", "depth", "wall_ms", "cpu_ms", "count"}], "counters": {name: value}}
+        Under -fperf-counters each phase also carries "cycles", "instructions", "cache_references",
+        "cache_misses", "branches", "branch_misses" and "ipc". Under -fmem-report each phase carries
+        "allocations", "allocated_bytes" and "live_bytes", next to top-level
+        "structures": {name: {"bytes", "allocations"}} and "peak_rss_bytes"
+    */
+    void CompileStats::reportJson(std::ostream& os) const {
+        os << "{\"phases\": [";
+        for(size_t i = 0; i < phases.size(); i++) {
+            const Phase& phase = phases[i];
+            if(i) os << ", ";
+            os << "{\"name\": \"" << phase.name << "\", \"depth\": " << phase.depth
+               << ", \"wall_ms\": " << phase.wallMs << ", \"cpu_ms\": " << phase.cpuMs << ", \"count\": " << phase.count;
+            if(perf.available()) {
+                const PerfSample& sample = phase.perf;
+                os << ", \"cycles\": " << sample.cycles << ", \"instructions\": " << sample.instructions
+                   << ", \"cache_references\": " << sample.cacheReferences << ", \"cache_misses\": " << sample.cacheMisses
+                   << ", \"branches\": " << sample.branches << ", \"branch_misses\": " << sample.branchMisses
+                   << ", \"ipc\": " << sample.ipc();
+            }
+            if(memory) {
+                os << ", \"allocations\": " << phase.memory.allocations << ", \"allocated_bytes\": " << phase.memory.allocatedBytes
+                   << ", \"live_bytes\": " << phase.memory.liveBytes;
+            }
+            os << "}";
+        }
+
+        os << "], \"counters\": {";
+        for(size_t i = 0; i < counters.size(); i++) {
+            if(i) os << ", ";
+            os << "\"" << counters[i].first << "\": " << counters[i].second;
+        }
+        os << "}";
+
+        if(memory) {
+            os << ", \"structures\": {";
+            for(size_t i = 0; i < structures.size(); i++) {
+                if(i) os << ", ";
+                os << "\"" << structures[i].first << "\": {\"bytes\": " << structures[i].second.bytes
+                   << ", \"allocations\": " << structures[i].second.allocations << "}";
+            }
+            os << "}, \"peak_rss_bytes\": " << MemoryStats::peakRssBytes();
+        }
+        os << "}\n";
+    }
+
+} // namespace nvyc
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "MemoryStats.hpp"
+#include "PerfCounters.hpp"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Per-compilation timing and counters for -ftime-report / -stats, plus
+        hardware counters and heap usage per phase under -fperf-counters / -fmem-report. Owned by the CompilationContext, so each thread reports its own module.
+    */
+    class CompileStats {
+        public:
+            enum class Format {
+                TEXT,
+                JSON
+            };
+
+            struct Phase {
+                std::string name;
+                int depth;
+                double wallMs;
+                double cpuMs;
+                uint64_t count;
+                PerfSample perf;
+                MemoryStats::Sample memory;
+            };
+
+            /*
+                Times everything until it goes out of scope, does nothing while timing is off.
+                Also opens a span in the -ftime-trace output when the trace profiler is running.
+            */
+            class Scope {
+                private:
+                    CompileStats* stats;
+                    bool traced;
+                    size_t index;
+                    std::chrono::steady_clock::time_point wallStart;
+                    double cpuStart;
+                    PerfSample perfStart;
+                    MemoryStats::Sample memoryStart;
+
+                public:
+                    Scope(CompileStats* s, const std::string& name);
+                    Scope(Scope&& other) noexcept;
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+                    ~Scope();
+            };
+
+        private:
+            bool timing = false;
+            bool counting = false;
+            bool memory = false;
+            Format format = Format::TEXT;
+            PerfCounters perf;
+            std::vector<size_t> open; // Indices of the phases currently being timed
+            std::vector<Phase> phases;
+            std::vector<std::pair<std::string, uint64_t>> counters;
+            std::vector<std::pair<std::string, MemoryUsage>> structures;
+
+        public:
+            void enableTiming(Format fmt);
+            void enableCounters();
+            bool enablePerfCounters(std::string& error);
+            void enableMemory();
+            bool timingEnabled() const;
+            bool countersEnabled() const;
+            bool perfCountersEnabled() const;
+            bool memoryEnabled() const;
+
+            Scope time(const std::string& name);
+            size_t beginPhase(const std::string& name);
+            void addCounter(const std::string& name, uint64_t value);
+            void addStructure(const std::string& name, const MemoryUsage& usage);
+
+            const std::vector<Phase>& getPhases() const;
+            const std::vector<std::pair<std::string, uint64_t>>& getCounters() const;
+
+            void report(std::ostream& os) const;
+            void reportText(std::ostream& os) const;
+            void reportPhases(std::ostream& os) const;
+            void reportMemory(std::ostream& os) const;
+            void reportJson(std::ostream& os) const;
+
+            static double threadCpuMs();
+
+            // Least-squares slope of log(cost) over log(input size): ~1 is linear, ~2 quadratic. Non-positive points are skipped
+            static double scalingExponent(const std::vector<std::pair<double, double>>& points);
+    };
+
+} // namespace nvyc
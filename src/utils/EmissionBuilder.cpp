@@ -1,20 +1,75 @@
 #include "EmissionBuilder.hpp"
 #include "error/Error.hpp"
+#include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/OptimizationLevel.h"
+#include "llvm/Passes/StandardInstrumentations.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/GlobalIFunc.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Object/ArchiveWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/Triple.h"
+#include "llvm/TargetParser/X86TargetParser.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/IPO/ThinLTOBitcodeWriter.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <mutex>
+#include <optional>
 
 namespace nvyc {
 
 
-    EmissionBuilder::EmissionBuilder(const std::string& moduleName) :
-        llvmContext(),
+    EmissionBuilder::EmissionBuilder(CompilationContext& ctx, const std::string& moduleName) :
+        context(ctx),
+        threadSafeContext(std::make_unique<llvm::LLVMContext>()),
+        llvmContext(*threadSafeContext.getContext()),
         builder(llvmContext),
         module(std::make_unique<llvm::Module>(moduleName, llvmContext)),
         name(moduleName)
     {}
 
+    EmissionBuilder::~EmissionBuilder() = default;
+
+    CompilationContext& EmissionBuilder::getContext() {
+        return context;
+    }
+
     llvm::Module* EmissionBuilder::getModule() {
         return module.get();
     }
 
+    // Hands the finished module to the JIT, call resetModule before emitting anything else
+    llvm::orc::ThreadSafeModule EmissionBuilder::takeModule() {
+        return llvm::orc::ThreadSafeModule(std::move(module), threadSafeContext);
+    }
+
+    /*
+        Starts an empty module in the same context, keeping the target setup.
+        Symbols stay as they are, so later modules can refer to what earlier ones defined,
+        except for function callees, which belonged to the old module.
+    */
+    void EmissionBuilder::resetModule(const std::string& moduleName) {
+        module = std::make_unique<llvm::Module>(moduleName, llvmContext);
+        name = moduleName;
+        symbols.clearFunctions();
+
+        if(targetMachine) {
+            module->setTargetTriple(targetMachine->getTargetTriple().str());
+            module->setDataLayout(targetMachine->createDataLayout());
+        }
+    }
+
     llvm::IRBuilder<>& EmissionBuilder::getBuilder() {
         return builder;
     }
@@ -35,22 +90,35 @@ namespace nvyc {
         return symbols;
     }
 
+    SymbolId EmissionBuilder::symbolOf(const NASTNode* node) {
+        SymbolId id = node->getSymbolId();
+        if(id == NO_SYMBOL) {
+            id = symbols.intern(node->getData().str);
+            node->setSymbolId(id);
+        }
+        return id;
+    }
+
 
     // ----------------------------------------
     //               FUNCTIONS
     // ----------------------------------------
 
-    llvm::Function* EmissionBuilder::makeFunction(const std::string& name, std::vector<std::string>& argNames, std::vector<llvm::Type*> args, NodeType returnType, bool isVariadic) {
+    llvm::Function* EmissionBuilder::makeFunction(const std::string& name, std::vector<std::string>& argNames, std::vector<llvm::Type*> args, NodeType returnType, bool isVariadic, bool exported) {
 
         llvm::FunctionType* funcType = EmissionBuilder::buildFunction(args, returnType, isVariadic);
         
         llvm::Function* func = llvm::Function::Create(
             funcType,
-            llvm::Function::ExternalLinkage,
+            exported ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage,
             name,
             module.get()
         );
 
+        // Nothing outside the module can call it, so LLVM may drop, specialize or rewrite its arguments.
+        // Variadic functions keep the C convention, their va_list handling assumes it
+        if(!exported && !isVariadic) func->setCallingConv(llvm::CallingConv::Fast);
+
         int idx = 0;
         auto ArgIterator = func->arg_begin();
 
@@ -59,11 +127,130 @@ namespace nvyc {
             carg->setName(argNames.at(idx++));
         }
 
+        // Also what the backend uses per function, so LTO and the JIT see the same CPU as -emit-o
+        func->addFnAttr("target-cpu", targetCPU);
+        if(!targetFeatures.empty()) func->addFnAttr("target-features", targetFeatures);
+
         getSymbols().storeFunType(name, returnType);
+        getSymbols().storeFunction(name, func);
 
         return func;
     }
 
+    // Anything but a Function (an ifunc, a pointer) can't say, those are always called with the C convention
+    llvm::CallingConv::ID EmissionBuilder::callingConvOf(const llvm::Value* callee) {
+        const llvm::Function* function = llvm::dyn_cast<llvm::Function>(callee);
+        return function ? function->getCallingConv() : llvm::CallingConv::C;
+    }
+
+    llvm::CallInst* EmissionBuilder::createCall(llvm::IRBuilderBase& at, llvm::FunctionCallee callee, llvm::ArrayRef<llvm::Value*> args, const llvm::Twine& name) {
+        llvm::CallInst* call = at.CreateCall(callee, args, name);
+        call->setCallingConv(callingConvOf(callee.getCallee()));
+        return call;
+    }
+
+    // Bit of each feature in libgcc/compiler-rt's __cpu_model / __cpu_features2, filled by __cpu_indicator_init
+    static const std::unordered_map<std::string, unsigned> X86_CPU_FEATURES = {
+        {"sse4.2", llvm::X86::FEATURE_SSE4_2},
+        {"avx", llvm::X86::FEATURE_AVX},
+        {"avx2", llvm::X86::FEATURE_AVX2},
+        {"fma", llvm::X86::FEATURE_FMA},
+        {"bmi", llvm::X86::FEATURE_BMI},
+        {"bmi2", llvm::X86::FEATURE_BMI2},
+        {"avx512f", llvm::X86::FEATURE_AVX512F},
+        {"avx512vl", llvm::X86::FEATURE_AVX512VL},
+        {"avx512bw", llvm::X86::FEATURE_AVX512BW},
+        {"avx512dq", llvm::X86::FEATURE_AVX512DQ},
+        {"avx512cd", llvm::X86::FEATURE_AVX512CD},
+        {"avx512vnni", llvm::X86::FEATURE_AVX512VNNI},
+    };
+
+    /*
+        multiversion(avx2, avx512f, default)
+
+        The emitted body becomes name.default and is cloned once per
+        feature, with that feature added to the clone's target-features, so
+        the backend vectorizes each clone for its own ISA. name itself becomes
+        an ifunc. Its resolver runs once at load time and checks the
+        versions from last listed to first, so list them from least to most
+        capable.
+
+        Callers only see the ifunc, so every version is called with the C
+        convention (callingConvOf) and keeps it even when internal.
+    */
+    void EmissionBuilder::multiversionFunction(llvm::Function* func, const std::vector<std::string>& versions) {
+        std::string funcName = func->getName().str();
+        std::string triple = module->getTargetTriple().empty() ? llvm::sys::getDefaultTargetTriple() : module->getTargetTriple();
+
+        if(!llvm::Triple(triple).isX86()) {
+            Error::nvyerr_failcompile(2, "multiversion on " + funcName + " is only supported on x86 targets");
+        }
+        if(std::find(versions.begin(), versions.end(), "default") == versions.end()) {
+            Error::nvyerr_failcompile(2, "multiversion on " + funcName + " needs a default version");
+        }
+        for(const std::string& version : versions) {
+            if(version != "default" && !X86_CPU_FEATURES.contains(version)) {
+                Error::nvyerr_failcompile(2, "Unknown multiversion feature " + version + " on " + funcName);
+            }
+        }
+
+        llvm::GlobalValue::LinkageTypes linkage = func->getLinkage();
+        func->setName(funcName + ".default");
+        func->setLinkage(llvm::Function::InternalLinkage);
+        func->setCallingConv(llvm::CallingConv::C);
+
+        // Callers, including recursive calls in the clones, go through the ifunc
+        llvm::Function* resolver = llvm::Function::Create(
+            llvm::FunctionType::get(builder.getPtrTy(), false), llvm::Function::InternalLinkage, funcName + ".resolver", module.get()
+        );
+        llvm::GlobalIFunc* ifunc = llvm::GlobalIFunc::create(func->getFunctionType(), 0, linkage, funcName, resolver, module.get());
+        func->replaceAllUsesWith(ifunc);
+        getSymbols().storeFunction(funcName, llvm::FunctionCallee(func->getFunctionType(), ifunc));
+
+        std::vector<std::pair<std::string, llvm::Function*>> clones;
+        for(const std::string& version : versions) {
+            if(version == "default") continue;
+
+            llvm::ValueToValueMapTy map;
+            llvm::Function* clone = llvm::CloneFunction(func, map);
+            clone->setName(funcName + "." + version);
+            clone->addFnAttr("target-features", targetFeatures.empty() ? "+" + version : targetFeatures + ",+" + version);
+            clones.emplace_back(version, clone);
+        }
+
+        llvm::IRBuilder<> resolverBuilder(createBlock(resolver, "entry"));
+        llvm::Type* i32 = resolverBuilder.getInt32Ty();
+        llvm::StructType* cpuModelType = llvm::StructType::get(llvmContext, {i32, i32, i32, llvm::ArrayType::get(i32, 1)});
+        llvm::ArrayType* cpuFeatures2Type = llvm::ArrayType::get(i32, 3);
+        llvm::Constant* cpuModel = module->getOrInsertGlobal("__cpu_model", cpuModelType);
+        llvm::Constant* cpuFeatures2 = module->getOrInsertGlobal("__cpu_features2", cpuFeatures2Type);
+
+        createCall(resolverBuilder, module->getOrInsertFunction("__cpu_indicator_init", resolverBuilder.getVoidTy()));
+
+        for(auto it = clones.rbegin(); it != clones.rend(); it++) {
+            unsigned bit = X86_CPU_FEATURES.at(it->first);
+            llvm::Value* word = bit < 32
+                ? resolverBuilder.CreateConstInBoundsGEP2_32(cpuModelType, cpuModel, 0, 3)
+                : resolverBuilder.CreateConstInBoundsGEP2_32(cpuFeatures2Type, cpuFeatures2, 0, bit / 32 - 1);
+            if(bit < 32) word = resolverBuilder.CreateConstInBoundsGEP2_32(llvm::ArrayType::get(i32, 1), word, 0, 0);
+
+            llvm::Value* features = resolverBuilder.CreateLoad(i32, word);
+            llvm::Value* supported = resolverBuilder.CreateICmpNE(
+                resolverBuilder.CreateAnd(features, resolverBuilder.getInt32(1u << (bit % 32))), resolverBuilder.getInt32(0)
+            );
+
+            llvm::BasicBlock* selected = createBlock(resolver, it->first);
+            llvm::BasicBlock* next = createBlock(resolver, "not_" + it->first);
+            resolverBuilder.CreateCondBr(supported, selected, next);
+
+            llvm::IRBuilder<>(selected).CreateRet(it->second);
+            resolverBuilder.SetInsertPoint(next);
+        }
+        resolverBuilder.CreateRet(func);
+
+        context.getStats().addCounter("multiversioned functions", 1);
+    }
+
 
     llvm::FunctionType* EmissionBuilder::buildFunction(std::vector<llvm::Type*> args, NodeType type, bool isVariadic) {
         llvm::Type* ntype = EmissionBuilder::getNativeType(type);
@@ -107,8 +294,11 @@ namespace nvyc {
 
     }
 
+    // Allocas always go at the top of the entry block so mem2reg/SROA can see them
     llvm::Value* EmissionBuilder::createVariable(const std::string name, ResultType& type) {
-        auto alloca = builder.CreateAlloca(
+        llvm::BasicBlock& entry = builder.GetInsertBlock()->getParent()->getEntryBlock();
+        llvm::IRBuilder<> entryBuilder(&entry, entry.begin());
+        auto alloca = entryBuilder.CreateAlloca(
             type.llvmType,
             nullptr,
             name
@@ -122,6 +312,28 @@ namespace nvyc {
         builder.CreateStore(value, variable);
     }
 
+    // Only variables that have their address taken need memory, everything else is bound directly
+    void EmissionBuilder::defineVariable(const std::string name, ResultType& type, llvm::Value* value) {
+        if(getSymbols().escapes(name)) {
+            storeToVariable(createVariable(name, type), value);
+            return;
+        }
+
+        if(!value->hasName() && !llvm::isa<llvm::Constant>(value)) value->setName(name);
+        getSymbols().storeSSA(name, value);
+        getSymbols().storeVarType(name, type.nvyType, type.llvmType);
+    }
+
+    llvm::Value* EmissionBuilder::loadVariable(const std::string& name, llvm::Type* type) {
+        return loadVariable(symbols.intern(name), type);
+    }
+
+    llvm::Value* EmissionBuilder::loadVariable(SymbolId id, llvm::Type* type) {
+        llvm::Value* value = symbols.getSSA(id);
+        if(value) return value;
+        return builder.CreateLoad(type, symbols.getAlloca(id), symbols.nameOf(id) + "_val");
+    }
+
     llvm::Type* EmissionBuilder::getNativeType(NodeType type) {
         switch(type) {
             case NodeType::INT32_T:
@@ -151,9 +363,9 @@ namespace nvyc {
 
         // Either a literal, function call, or variable
         if(node->getSubnodes().empty()) {
-            if(symbols::LITERAL_SYMBOLS.count(type)) return type;
-            if(type == NodeType::FUNCTIONCALL) return getSymbols().getFunType(node->getData().str);
-            return getSymbols().getVarNvyType(node->getData().str);
+            if(symbols::isLiteral(type)) return type;
+            if(type == NodeType::FUNCTIONCALL) return getSymbols().getFunType(symbolOf(node));
+            return getSymbols().getVarNvyType(symbolOf(node));
         }
 
         // Struct access
@@ -167,25 +379,28 @@ namespace nvyc {
         return precedence;
     }
 
-    NodeType EmissionBuilder::typePrecedence(NodeType t1, NodeType t2) {
-        int t1_p = typeToPrecedence(t1);
-        int t2_p = typeToPrecedence(t2);
+    // Reads the annotation from annotateTypes, only inferring when the pass couldn't type the node
+    NodeType EmissionBuilder::resolvedType(const NASTNode* node) {
+        NodeType type = node->getResolvedType();
+        if(type != NodeType::INVALID) return type;
+        return arithmeticPrecedence(node);
+    }
 
-        if(t1_p > t2_p) return t1;
-        else return t2;
+    llvm::Type* EmissionBuilder::resolvedNativeType(const NASTNode* node) {
+        llvm::Type* type = node->getNativeType();
+        if(!type) {
+            type = getNativeType(resolvedType(node));
+            node->setNativeType(type);
+        }
+        return type;
+    }
 
+    NodeType EmissionBuilder::typePrecedence(NodeType t1, NodeType t2) {
+        return symbols::promoteNumeric(t1, t2);
     }
 
     int EmissionBuilder::typeToPrecedence(NodeType type) {
-        switch(type) {
-            case NodeType::CHAR:    return -1;
-            case NodeType::SHORT:   return 0;
-            case NodeType::INT32:   return 1;
-            case NodeType::INT64:   return 2;
-            case NodeType::FP32:    return 3;
-            case NodeType::FP64:    return 4;
-            default:                return -10;
-        }
+        return symbols::numericRank(type);
     }
 
     NodeType EmissionBuilder::precedenceToType(int precedence) {
@@ -318,4 +533,356 @@ namespace nvyc {
             result->llvmType = ty;
         }
     }
-}
\ No newline at end of file
+
+
+    // ----------------------------------------
+    //              OPTIMIZATION
+    // ----------------------------------------
+
+    static llvm::OptimizationLevel toLLVMLevel(OptLevel level) {
+        switch(level) {
+            case OptLevel::O1: return llvm::OptimizationLevel::O1;
+            case OptLevel::O2: return llvm::OptimizationLevel::O2;
+            case OptLevel::O3: return llvm::OptimizationLevel::O3;
+            case OptLevel::Os: return llvm::OptimizationLevel::Os;
+            case OptLevel::Oz: return llvm::OptimizationLevel::Oz;
+            default: return llvm::OptimizationLevel::O0;
+        }
+    }
+
+    void EmissionBuilder::optimize(OptLevel level, LTOMode lto) {
+        auto scope = context.getStats().time("optimize");
+        llvm::OptimizationLevel llvmLevel = toLLVMLevel(level);
+        getTargetMachine(level);
+
+        // The optimizer assumes well formed IR, so catch emitter bugs here instead of inside a pass
+        if(level != OptLevel::O0) {
+            std::string errors;
+            llvm::raw_string_ostream os(errors);
+            if(llvm::verifyModule(*module, &os)) {
+                Error::nvyerr_failcompile(2, "Generated invalid IR for module " + name + "\n" + os.str());
+            }
+        }
+
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+
+        // Per-pass spans for -ftime-trace come from the standard instrumentation
+        llvm::PassInstrumentationCallbacks pic;
+        llvm::StandardInstrumentations si(llvmContext, false);
+        si.registerCallbacks(pic, &mam);
+
+        // The target machine gives the vectorizer and unroller real cost models
+        llvm::PassBuilder passBuilder(getTargetMachine(level), llvm::PipelineTuningOptions(), pgoOptions, &pic);
+
+        passBuilder.registerModuleAnalyses(mam);
+        passBuilder.registerCGSCCAnalyses(cgam);
+        passBuilder.registerFunctionAnalyses(fam);
+        passBuilder.registerLoopAnalyses(lam);
+        passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+        // Pre-link pipelines leave inlining across modules and the late loop passes to the LTO backend
+        llvm::ModulePassManager mpm;
+        if(level == OptLevel::O0)           mpm = passBuilder.buildO0DefaultPipeline(llvmLevel, lto != LTOMode::NONE);
+        else if(lto == LTOMode::THIN)       mpm = passBuilder.buildThinLTOPreLinkDefaultPipeline(llvmLevel);
+        else if(lto == LTOMode::FULL)       mpm = passBuilder.buildLTOPreLinkDefaultPipeline(llvmLevel);
+        else                                mpm = passBuilder.buildPerModuleDefaultPipeline(llvmLevel);
+
+        mpm.run(*module, mam);
+    }
+
+
+    /*
+        IR-level PGO. Instrumentation and profile use both run inside the
+        default pipelines, including O0 and the LTO pre-link ones. Only
+        optimize() applies them: the streaming compile's per-function pipeline
+        has no module to put counters in.
+
+        Instrumented code references __llvm_profile_runtime, so the program
+        has to be linked against compiler-rt's profile runtime, which writes
+        the .profraw at exit.
+    */
+    void EmissionBuilder::setProfileGenerate(const std::string& rawProfile) {
+        pgoOptions = llvm::PGOOptions(rawProfile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+    }
+
+    bool EmissionBuilder::setProfileUse(const std::string& profile) {
+        if(!llvm::sys::fs::exists(profile)) {
+            Error::nvyerr_out("Profile " + profile + " does not exist");
+            return false;
+        }
+        pgoOptions = llvm::PGOOptions(profile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+        return true;
+    }
+
+
+    struct EmissionBuilder::FunctionPipeline {
+        OptLevel level;
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+        llvm::PassBuilder passBuilder;
+        llvm::FunctionPassManager fpm;
+    };
+
+    /*
+        Per-function counterpart of optimize(). Interprocedural work (inlining,
+        global DCE) needs the whole module and is left to optimize().
+    */
+    void EmissionBuilder::optimizeFunction(llvm::Function* function, OptLevel level) {
+        if(level == OptLevel::O0 || !function || function->isDeclaration()) return;
+        auto scope = context.getStats().time("optimizeFunction");
+
+        std::string errors;
+        llvm::raw_string_ostream os(errors);
+        if(llvm::verifyFunction(*function, &os)) {
+            Error::nvyerr_failcompile(2, "Generated invalid IR for function " + function->getName().str() + "\n" + os.str());
+        }
+
+        if(!functionPipeline || functionPipeline->level != level) {
+            functionPipeline = std::make_unique<FunctionPipeline>();
+            FunctionPipeline& pipeline = *functionPipeline;
+            pipeline.level = level;
+
+            pipeline.passBuilder.registerModuleAnalyses(pipeline.mam);
+            pipeline.passBuilder.registerCGSCCAnalyses(pipeline.cgam);
+            pipeline.passBuilder.registerFunctionAnalyses(pipeline.fam);
+            pipeline.passBuilder.registerLoopAnalyses(pipeline.lam);
+            pipeline.passBuilder.crossRegisterProxies(pipeline.lam, pipeline.fam, pipeline.cgam, pipeline.mam);
+
+            pipeline.fpm = pipeline.passBuilder.buildFunctionSimplificationPipeline(toLLVMLevel(level), llvm::ThinOrFullLTOPhase::None);
+        }
+
+        functionPipeline->fpm.run(*function, functionPipeline->fam);
+
+        // Nothing looks at this function again, so don't let its analyses pile up
+        functionPipeline->fam.clear(*function, function->getName());
+    }
+
+
+    // ----------------------------------------
+    //                CODEGEN
+    // ----------------------------------------
+
+    // Codegen and the JIT both need the host target registered, once per process
+    void EmissionBuilder::initializeNativeTarget() {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            llvm::InitializeNativeTarget();
+            llvm::InitializeNativeTargetAsmPrinter();
+            llvm::InitializeNativeTargetAsmParser();
+        });
+    }
+
+    llvm::CodeGenOpt::Level EmissionBuilder::toCodeGenLevel(OptLevel level) {
+        switch(level) {
+            case OptLevel::O0: return llvm::CodeGenOpt::None;
+            case OptLevel::O1: return llvm::CodeGenOpt::Less;
+            case OptLevel::O3: return llvm::CodeGenOpt::Aggressive;
+            default: return llvm::CodeGenOpt::Default;
+        }
+    }
+
+    // Each codegen thread needs a TargetMachine of its own, so this stays free of EmissionBuilder state
+    static std::unique_ptr<llvm::TargetMachine> createTargetMachine(const std::string& triple, const std::string& cpu, const std::string& features,
+                                                                    OptLevel level, std::string& error) {
+        EmissionBuilder::initializeNativeTarget();
+
+        const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+        if(!target) return nullptr;
+
+        llvm::TargetOptions options;
+        return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+            triple, cpu, features, options, llvm::Reloc::PIC_, std::nullopt, EmissionBuilder::toCodeGenLevel(level)
+        ));
+    }
+
+    /*
+        Applies to functions made after this call, so it is set before
+        emission. The TargetMachine is rebuilt on next use.
+    */
+    void EmissionBuilder::setTarget(const std::string& cpu, const std::string& features) {
+        targetCPU = cpu;
+        targetFeatures = features;
+        resolveTarget(targetCPU, targetFeatures);
+        targetMachine.reset();
+    }
+
+    // "native" is the host CPU with every feature it reports, explicit -mattr entries come after and win
+    void EmissionBuilder::resolveTarget(std::string& cpu, std::string& features) {
+        if(cpu.empty()) cpu = "generic";
+        if(cpu != "native") return;
+
+        cpu = llvm::sys::getHostCPUName().str();
+
+        llvm::StringMap<bool> hostFeatures;
+        if(!llvm::sys::getHostCPUFeatures(hostFeatures)) return;
+
+        std::string resolved;
+        for(const auto& feature : hostFeatures) {
+            if(!resolved.empty()) resolved += ",";
+            resolved += (feature.getValue() ? "+" : "-") + feature.getKey().str();
+        }
+        features = features.empty() ? resolved : resolved + "," + features;
+    }
+
+    /*
+        Created on first use and stamped onto the module, so the optimizer
+        and codegen agree on the triple and data layout
+    */
+    llvm::TargetMachine* EmissionBuilder::getTargetMachine(OptLevel level) {
+        if(targetMachine && targetLevel == level) return targetMachine.get();
+
+        std::string triple = module->getTargetTriple().empty() ? llvm::sys::getDefaultTargetTriple() : module->getTargetTriple();
+        std::string error;
+        targetMachine = createTargetMachine(triple, targetCPU, targetFeatures, level, error);
+        targetLevel = level;
+
+        if(!targetMachine) {
+            Error::nvyerr_out("No target for " + triple + ": " + error);
+            return nullptr;
+        }
+
+        module->setTargetTriple(triple);
+        module->setDataLayout(targetMachine->createDataLayout());
+        return targetMachine.get();
+    }
+
+    /*
+        Object or assembly bytes for the module, entirely in memory: no .ll on
+        disk and no llc/clang subprocess, so embedders and the build cache can
+        take the result directly.
+
+        OBJECT and ASSEMBLY are always one partition on the calling thread,
+        jobs is ignored (CompileOptions rejects -j with -emit-o/-emit-S). For
+        ARCHIVE, jobs > 1 splits the module (llvm::SplitModule through
+        splitCodeGen) and every partition is compiled on its own thread with
+        its own LLVMContext and TargetMachine. LLVM has no in-process
+        relocatable linker to merge them back into one object, so they are
+        packed into an ar archive, which is only produced when asked for
+        (-emit-a).
+    */
+    bool EmissionBuilder::emitToBuffer(llvm::SmallVectorImpl<char>& out, OutputKind kind, OptLevel level, unsigned jobs) {
+        auto scope = context.getStats().time("codegen");
+        out.clear();
+
+        llvm::TargetMachine* machine = getTargetMachine(level);
+        if(!machine) return false;
+
+        llvm::CodeGenFileType fileType = kind == OutputKind::ASSEMBLY ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+
+        // More partitions than function definitions only adds empty objects
+        unsigned definitions = 0;
+        for(const llvm::Function& func : *module) {
+            if(!func.isDeclaration()) definitions++;
+        }
+        unsigned partitions = kind == OutputKind::ARCHIVE ? std::clamp(jobs, 1u, std::max(definitions, 1u)) : 1;
+        context.getStats().addCounter("codegen partitions", partitions);
+
+        // A single object or assembly file goes straight into the caller's buffer
+        if(kind != OutputKind::ARCHIVE) {
+            llvm::raw_svector_ostream os(out);
+            llvm::legacy::PassManager codegen;
+            if(machine->addPassesToEmitFile(codegen, os, nullptr, fileType)) {
+                Error::nvyerr_out("Target can't emit this file type");
+                return false;
+            }
+            codegen.run(*module);
+            return true;
+        }
+
+        std::vector<llvm::SmallString<0>> buffers(partitions);
+        std::vector<std::unique_ptr<llvm::raw_svector_ostream>> streams;
+        std::vector<llvm::raw_pwrite_stream*> outputs;
+        for(auto& buffer : buffers) {
+            streams.push_back(std::make_unique<llvm::raw_svector_ostream>(buffer));
+            outputs.push_back(streams.back().get());
+        }
+
+        std::string triple = module->getTargetTriple();
+        llvm::splitCodeGen(*module, outputs, {}, [&] {
+            std::string error;
+            return createTargetMachine(triple, targetCPU, targetFeatures, level, error);
+        }, fileType);
+
+        return archiveObjects(buffers, name + ".part", out);
+    }
+
+    bool EmissionBuilder::archiveObjects(const std::vector<llvm::SmallString<0>>& objects, const std::string& prefix, llvm::SmallVectorImpl<char>& out) {
+        out.clear();
+
+        std::vector<std::string> names;
+        std::vector<llvm::NewArchiveMember> members;
+        for(size_t i = 0; i < objects.size(); i++) {
+            names.push_back(prefix + std::to_string(i) + ".o");
+        }
+        for(size_t i = 0; i < objects.size(); i++) {
+            members.emplace_back(llvm::MemoryBufferRef(llvm::StringRef(objects[i].data(), objects[i].size()), names[i]));
+        }
+
+        auto archive = llvm::writeArchiveToBuffer(members, true, llvm::object::Archive::K_GNU, true, false);
+        if(!archive) {
+            Error::nvyerr_out("Could not archive objects: " + llvm::toString(archive.takeError()));
+            return false;
+        }
+        out.append((*archive)->getBufferStart(), (*archive)->getBufferEnd());
+        return true;
+    }
+
+    /*
+        Bitcode for -flto. ThinLTO modules go through the ThinLTO bitcode
+        writer. Full LTO modules still carry a summary, but the ThinLTO=0 flag
+        keeps them in the regular LTO partition, the same as clang -flto=full.
+    */
+    bool EmissionBuilder::emitBitcode(llvm::SmallVectorImpl<char>& out, LTOMode lto) {
+        auto scope = context.getStats().time("emitBitcode");
+        out.clear();
+        llvm::raw_svector_ostream os(out);
+
+        if(lto == LTOMode::FULL && !module->getModuleFlag("ThinLTO")) {
+            module->addModuleFlag(llvm::Module::Error, "ThinLTO", uint32_t(0));
+        }
+
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+
+        llvm::PassBuilder passBuilder(getTargetMachine(targetLevel));
+        passBuilder.registerModuleAnalyses(mam);
+        passBuilder.registerCGSCCAnalyses(cgam);
+        passBuilder.registerFunctionAnalyses(fam);
+        passBuilder.registerLoopAnalyses(lam);
+        passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+        llvm::ModulePassManager mpm;
+        if(lto == LTOMode::THIN) mpm.addPass(llvm::ThinLTOBitcodeWriterPass(os, nullptr));
+        else                     mpm.addPass(llvm::BitcodeWriterPass(os, false, lto != LTOMode::NONE));
+        mpm.run(*module, mam);
+        return true;
+    }
+
+    // Output is only opened once codegen has succeeded, and written in one go
+    bool EmissionBuilder::emitFile(const std::string& path, OutputKind kind, OptLevel level, unsigned jobs) {
+        // Linkers and build systems take a .o for a single object
+        if(kind == OutputKind::ARCHIVE && path.ends_with(".o")) {
+            Error::nvyerr_out("Refusing to write an archive to " + path + ", use a .a name with -emit-a");
+            return false;
+        }
+
+        llvm::SmallVector<char, 0> bytes;
+        if(!emitToBuffer(bytes, kind, level, jobs)) return false;
+
+        std::error_code ec;
+        llvm::raw_fd_ostream file(path, ec, kind == OutputKind::ASSEMBLY ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+        if(ec) {
+            Error::nvyerr_out("Could not open " + path + ": " + ec.message());
+            return false;
+        }
+        file.write(bytes.data(), bytes.size());
+        return true;
+    }
+}
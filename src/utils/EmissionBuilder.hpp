@@ -8,10 +8,18 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Constant.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/PGOOptions.h"
 #include "data/NASTNode.hpp"
 #include "data/NodeType.hpp"
 #include "SymbolStorage.hpp"
+#include "CompilationContext.hpp"
+#include "CompileOptions.hpp"
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -20,17 +28,37 @@
 using nvyc::NASTNode;
 using nvyc::NodeType;
 
+namespace llvm {
+    class TargetMachine;
+}
+
 namespace nvyc {
 
     class EmissionBuilder {
         private:
-            llvm::LLVMContext llvmContext;
+            CompilationContext& context;
+            // Shared with the JIT, so modules handed to it keep their context alive
+            llvm::orc::ThreadSafeContext threadSafeContext;
+            llvm::LLVMContext& llvmContext;
             llvm::IRBuilder<> builder;
             std::unique_ptr<llvm::Module> module;
             std::string name;
             int registerId = 0;
             SymbolStorage symbols;
 
+            // Host target, created on first use for the level it was asked for
+            std::unique_ptr<llvm::TargetMachine> targetMachine;
+            OptLevel targetLevel = OptLevel::O0;
+            std::string targetCPU = "generic";
+            std::string targetFeatures;
+
+            // -fprofile-generate / -fprofile-use, handed to every PassBuilder optimize() creates
+            std::optional<llvm::PGOOptions> pgoOptions;
+
+            // Reused across optimizeFunction calls, declared last so it goes before the LLVMContext
+            struct FunctionPipeline;
+            std::unique_ptr<FunctionPipeline> functionPipeline;
+
         public:
             enum class NumericType {
                 FLOAT,
@@ -46,16 +74,28 @@ namespace nvyc {
                 FLOAT_I64
             };
 
+            enum class OutputKind {
+                OBJECT,
+                ASSEMBLY,
+                ARCHIVE // -emit-a, an ar archive with one object per codegen partition
+            };
+
             struct ResultType {
                 NodeType nvyType;
                 llvm::Type* llvmType;
             };
 
-            EmissionBuilder(const std::string& moduleName);
+            EmissionBuilder(CompilationContext& ctx, const std::string& moduleName);
+            ~EmissionBuilder();
 
+            CompilationContext& getContext();
             llvm::Module* getModule();
+            llvm::orc::ThreadSafeModule takeModule();
+            void resetModule(const std::string& moduleName);
             llvm::IRBuilder<>& getBuilder();
             SymbolStorage& getSymbols();
+            // Interned once per node, later uses skip the name lookup
+            SymbolId symbolOf(const NASTNode* node);
 
             std::string getCurrentRegister();
             std::string getAndIncrementRegister();
@@ -67,12 +107,19 @@ namespace nvyc {
                 std::vector<std::string>& argNames,
                 std::vector<llvm::Type*> args,
                 NodeType returnType,
-                bool isVariadic
+                bool isVariadic,
+                bool exported = true // Internal linkage and fastcc when false
             );
 
+            // Every call site goes through this so it matches the callee's convention (fastcc for internal functions)
+            static llvm::CallInst* createCall(llvm::IRBuilderBase& at, llvm::FunctionCallee callee, llvm::ArrayRef<llvm::Value*> args = {}, const llvm::Twine& name = "");
+            static llvm::CallingConv::ID callingConvOf(const llvm::Value* callee);
+
             NodeType typePrecedence(NodeType t1, NodeType t2);
             int lrPrecedence(NodeType t1, NodeType t2);
             NodeType arithmeticPrecedence(const NASTNode* node);
+            NodeType resolvedType(const NASTNode* node);
+            llvm::Type* resolvedNativeType(const NASTNode* node);
             int typeToPrecedence(NodeType type);
             NodeType precedenceToType(int precedence);
             llvm::Value* createArithmeticOperation(NodeType type, NumericType mode, llvm::Value* lhs, llvm::Value* rhs);
@@ -83,16 +130,53 @@ namespace nvyc {
 
             void populateType(ResultType* result, NodeType type, llvm::Type* ty);
 
+            // Clones of func per CPU feature, picked at load time by an ifunc that takes over its name
+            void multiversionFunction(llvm::Function* func, const std::vector<std::string>& versions);
+
             llvm::FunctionType* buildFunction(std::vector<llvm::Type*> args, NodeType type, bool isVariadic);
             void addReturnValue(llvm::BasicBlock* block, llvm::Value* rv);
             llvm::BasicBlock* createBlock(llvm::Function* func, const std::string name);
             llvm::Value* createVariable(const std::string name, ResultType& type);
+            void defineVariable(const std::string name, ResultType& type, llvm::Value* value);
+            llvm::Value* loadVariable(const std::string& name, llvm::Type* type);
+            llvm::Value* loadVariable(SymbolId id, llvm::Type* type);
             NodeType getNvyType(llvm::Type* type);
             void setInsertionPoint(llvm::BasicBlock* block);
             llvm::Type* getNativeType(NodeType type);
             void addConstReturnValue(llvm::BasicBlock* block, int i);
             void storeToVariable(llvm::Value* variable, llvm::Value* value);
 
+            // Runs LLVM's default per-module pipeline for the level over the finished module,
+            // or the (Thin)LTO pre-link pipeline when the module goes to LTOLinker afterwards
+            void optimize(OptLevel level, LTOMode lto = LTOMode::NONE);
+
+            // Instrument with InstrProf counters, the program writes rawProfile (or the runtime default) at exit
+            void setProfileGenerate(const std::string& rawProfile);
+
+            // Branch weights and entry counts from an indexed profile, false if it can't be read
+            bool setProfileUse(const std::string& profile);
+
+            // Function simplification pipeline over one finished function, for the streaming compile
+            void optimizeFunction(llvm::Function* function, OptLevel level);
+
+            static void initializeNativeTarget();
+
+            // -march/-mcpu/-mattr for the TargetMachine and every function's target-cpu/target-features
+            void setTarget(const std::string& cpu, const std::string& features);
+            static void resolveTarget(std::string& cpu, std::string& features);
+            static llvm::CodeGenOpt::Level toCodeGenLevel(OptLevel level);
+
+            // Codegen through the host TargetMachine (-emit-o / -emit-S / -emit-a), jobs > 1 splits the module for ARCHIVE only
+            llvm::TargetMachine* getTargetMachine(OptLevel level);
+            bool emitToBuffer(llvm::SmallVectorImpl<char>& out, OutputKind kind, OptLevel level, unsigned jobs = 1);
+            bool emitFile(const std::string& path, OutputKind kind, OptLevel level, unsigned jobs = 1);
+
+            // Bitcode for -flto, with the module summary LTOLinker needs
+            bool emitBitcode(llvm::SmallVectorImpl<char>& out, LTOMode lto);
+
+            // Packs objects into an ar archive as <prefix><N>.o
+            static bool archiveObjects(const std::vector<llvm::SmallString<0>>& objects, const std::string& prefix, llvm::SmallVectorImpl<char>& out);
+
             // Replacement for getValue() in LLVMEmission
             /*
             template <typename T>
@@ -0,0 +1,136 @@
+#include "JITObjectCache.hpp"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+namespace nvyc {
+
+    JITObjectCache::JITObjectCache(CompilationContext& ctx, const std::string& dir, uint64_t maxSize)
+    : context(ctx), directory(dir), maxBytes(maxSize)
+    {
+        if(directory.empty()) return;
+
+        std::error_code ec = llvm::sys::fs::create_directories(directory);
+        if(ec) {
+            context.getDebug().debug("JIT cache disabled, cannot create " + directory + ": " + ec.message());
+            return;
+        }
+        usable = true;
+    }
+
+    JITObjectCache::~JITObjectCache() {
+        if(!usable) return;
+
+        context.getStats().addCounter("jit cache hits", hits);
+        context.getStats().addCounter("jit cache misses", misses);
+
+        // Size bound only, no expiry: oldest access time goes first until the directory fits
+        llvm::CachePruningPolicy policy;
+        policy.Interval = std::chrono::seconds(0);
+        policy.Expiration = std::chrono::seconds(0);
+        policy.MaxSizePercentageOfAvailableSpace = 0;
+        policy.MaxSizeBytes = maxBytes;
+        llvm::pruneCache(directory, policy);
+    }
+
+    std::string JITObjectCache::defaultDirectory() {
+        llvm::SmallString<128> path;
+        if(!llvm::sys::path::cache_directory(path)) return "";
+        llvm::sys::path::append(path, "nvyc", "jit");
+        return std::string(path);
+    }
+
+    void JITObjectCache::setTarget(const llvm::TargetMachine& tm) {
+        target = tm.getTargetTriple().str() + "/" + tm.getTargetCPU().str() + "/" + tm.getTargetFeatureString().str();
+    }
+
+    bool JITObjectCache::valid() const {
+        return usable;
+    }
+
+    std::string JITObjectCache::key(const llvm::Module& module) const {
+        llvm::SmallVector<char, 0> bitcode;
+        llvm::raw_svector_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(module, os);
+
+        llvm::SHA256 hash;
+        hash.update(target);
+        hash.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+        return llvm::toHex(hash.final(), /*LowerCase=*/true);
+    }
+
+    std::string JITObjectCache::entryPath(const std::string& key) const {
+        llvm::SmallString<128> path(directory);
+        llvm::sys::path::append(path, "llvmcache-" + key);
+        return std::string(path);
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> JITObjectCache::getObject(const llvm::Module* module) {
+        if(!usable) return nullptr;
+
+        std::string entry = key(*module);
+        std::string path = entryPath(entry);
+
+        auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+        if(!buffer) {
+            misses++;
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending[module] = std::move(entry);
+            return nullptr;
+        }
+
+        // Refresh the entry so pruning treats it as recently used
+        int fd;
+        if(!llvm::sys::fs::openFileForReadWrite(path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_None)) {
+            llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+            llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+        }
+
+        hits++;
+        return std::move(*buffer);
+    }
+
+    void JITObjectCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+        if(!usable) return;
+
+        std::string entry;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto it = pending.find(module);
+            if(it == pending.end()) return;
+            entry = std::move(it->second);
+            pending.erase(it);
+        }
+
+        // Write then rename, so another nvyc never maps a half-written object
+        llvm::SmallString<128> model(directory);
+        llvm::sys::path::append(model, "llvmcache-tmp-%%%%%%%%");
+
+        int fd;
+        llvm::SmallString<128> tempPath;
+        if(llvm::sys::fs::createUniqueFile(model, fd, tempPath)) return;
+        {
+            llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+            os << object.getBuffer();
+            if(os.has_error()) {
+                os.clear_error();
+                llvm::sys::fs::remove(tempPath);
+                return;
+            }
+        }
+
+        if(std::error_code ec = llvm::sys::fs::rename(tempPath, entryPath(entry))) {
+            context.getDebug().debug("JIT cache could not store " + entry + ": " + ec.message());
+            llvm::sys::fs::remove(tempPath);
+        }
+    }
+
+} // namespace nvyc
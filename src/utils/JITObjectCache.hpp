@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CompilationContext.hpp"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Target/TargetMachine.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace nvyc {
+
+    /*
+        On-disk object cache for the JIT (-run). Every module that reaches the
+        JIT's compile layer is keyed by a SHA-256 of its bitcode (already
+        optimized by EmissionBuilder) plus the target triple, CPU and features,
+        so a warm run loads the object straight from disk and skips the backend.
+
+        Entries are llvmcache-<key> files in one directory, shared between
+        processes. They are written to a temporary file and renamed into
+        place. Hits refresh the entry's access time, and the directory is
+        pruned to maxBytes when the cache is destroyed, least recently used
+        first (llvm::pruneCache).
+
+        With the lazy JIT each function partition is its own entry.
+    */
+    class JITObjectCache : public llvm::ObjectCache {
+        private:
+            CompilationContext& context;
+            std::string directory;
+            uint64_t maxBytes;
+            std::string target; // triple/cpu/features, mixed into every key
+            bool usable = false;
+
+            // Key computed in getObject, reused when the same module comes back compiled
+            std::mutex pendingMutex;
+            std::unordered_map<const llvm::Module*, std::string> pending;
+
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+
+            std::string key(const llvm::Module& module) const;
+            std::string entryPath(const std::string& key) const;
+
+        public:
+            JITObjectCache(CompilationContext& ctx, const std::string& dir, uint64_t maxSize);
+            ~JITObjectCache() override;
+
+            JITObjectCache(const JITObjectCache&) = delete;
+            JITObjectCache& operator=(const JITObjectCache&) = delete;
+
+            // $XDG_CACHE_HOME/nvyc/jit or the platform equivalent, empty if there is none
+            static std::string defaultDirectory();
+
+            // Must be called with the JIT's TargetMachine before anything is compiled
+            void setTarget(const llvm::TargetMachine& tm);
+
+            bool valid() const;
+
+            void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+            std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+    };
+
+} // namespace nvyc
@@ -0,0 +1,175 @@
+#include "JITSession.hpp"
+#include "EmissionBuilder.hpp"
+#include "error/Error.hpp"
+#include "passes/CompilationPasses.hpp"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+
+namespace nvyc {
+
+    JITSession::JITSession(CompilationContext& ctx, bool lazy, const std::string& cacheDir, uint64_t cacheBytes) : context(ctx) {
+        EmissionBuilder::initializeNativeTarget();
+
+        if(!cacheDir.empty()) {
+            cache = std::make_unique<JITObjectCache>(context, cacheDir, cacheBytes);
+            if(!cache->valid()) cache.reset();
+        }
+
+        // Same compiler LLJIT would pick by default, plus the cache in front of it
+        auto compiler = [this](llvm::orc::JITTargetMachineBuilder jtmb)
+            -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+            auto tm = jtmb.createTargetMachine();
+            if(!tm) return tm.takeError();
+            if(cache) cache->setTarget(**tm);
+            return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*tm), cache.get());
+        };
+
+        if(lazy) {
+            llvm::orc::LLLazyJITBuilder builder;
+            if(cache) builder.setCompileFunctionCreator(compiler);
+            auto created = builder.create();
+            if(!created) {
+                Error::nvyerr_out("Could not start the JIT: " + llvm::toString(created.takeError()));
+                return;
+            }
+            lazyJit = created->get();
+            jit = std::move(*created);
+        }
+        else {
+            llvm::orc::LLJITBuilder builder;
+            if(cache) builder.setCompileFunctionCreator(compiler);
+            auto created = builder.create();
+            if(!created) {
+                Error::nvyerr_out("Could not start the JIT: " + llvm::toString(created.takeError()));
+                return;
+            }
+            jit = std::move(*created);
+        }
+
+        // Natives are plain C symbols, look them up in the running process
+        auto host = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+        if(!host) {
+            Error::nvyerr_out("Could not expose host symbols to the JIT: " + llvm::toString(host.takeError()));
+            return;
+        }
+        jit->getMainJITDylib().addGenerator(std::move(*host));
+    }
+
+    bool JITSession::valid() const {
+        return jit != nullptr;
+    }
+
+    bool JITSession::addModule(llvm::orc::ThreadSafeModule module) {
+        if(!jit) return false;
+        auto scope = context.getStats().time("jitAddModule");
+
+        // The IR is gone once the JIT has it, so main's signature is taken now
+        module.withModuleDo([this](llvm::Module& m) { recordMain(m); });
+
+        llvm::Error err = lazyJit ? lazyJit->addLazyIRModule(std::move(module)) : jit->addIRModule(std::move(module));
+        if(err) {
+            Error::nvyerr_out("Could not add module to the JIT: " + llvm::toString(std::move(err)));
+            return false;
+        }
+        return true;
+    }
+
+    void JITSession::recordMain(llvm::Module& module) {
+        for(const std::string& target : Passes::resolveCallTargets(context, "main")) {
+            // A multiversioned main is an ifunc, which has the same value type
+            llvm::GlobalValue* main = module.getNamedValue(target);
+            if(!main || main->isDeclaration()) continue;
+            auto* type = llvm::dyn_cast<llvm::FunctionType>(main->getValueType());
+            if(!type) continue;
+
+            MainSignature signature;
+            llvm::Type* returnType = type->getReturnType();
+            if(returnType->isIntegerTy(32)) signature.returns = MainReturn::INT32;
+            else if(returnType->isIntegerTy(64)) signature.returns = MainReturn::INT64;
+            else if(returnType->isVoidTy()) signature.returns = MainReturn::VOID;
+            else signature.unsupported = "main must return int32, int64 or void to be run";
+
+            if(type->getNumParams() == 2 && type->getParamType(0)->isIntegerTy(32) && type->getParamType(1)->isPointerTy()) {
+                signature.takesArgs = true;
+            }
+            else if(type->getNumParams() != 0 || type->isVarArg()) {
+                signature.unsupported = "main must take no parameters or (int32 argc, argv) to be run";
+            }
+
+            mainSignature = signature;
+            return;
+        }
+    }
+
+    void* JITSession::lookup(const std::string& name) {
+        if(!jit) return nullptr;
+
+        auto address = jit->lookup(name);
+        if(!address) {
+            llvm::consumeError(address.takeError());
+            return nullptr;
+        }
+        return address->toPtr<void*>();
+    }
+
+    // main as it was declared, argc and argv are only passed if it takes them
+    template<typename R>
+    static R callMain(void* address, bool takesArgs, int argc, char** argv) {
+        if(takesArgs) return reinterpret_cast<R (*)(int, char**)>(address)(argc, argv);
+        return reinterpret_cast<R (*)()>(address)();
+    }
+
+    int JITSession::runMain(const std::vector<std::string>& args) {
+        if(!mainSignature) {
+            Error::nvyerr_out("No main function to run in " + context.getModuleName());
+            return 1;
+        }
+        if(!mainSignature->unsupported.empty()) {
+            Error::nvyerr_out(mainSignature->unsupported);
+            return 1;
+        }
+
+        void* address = nullptr;
+
+        // With the lazy JIT this lookup is what triggers compiling main
+        {
+            auto scope = context.getStats().time("jitLookup");
+            for(const std::string& target : Passes::resolveCallTargets(context, "main")) {
+                address = lookup(target);
+                if(address) break;
+            }
+        }
+
+        if(!address) {
+            Error::nvyerr_out("No main function to run in " + context.getModuleName());
+            return 1;
+        }
+
+        // argv[0] is the module name, as a linked program would see its own path
+        std::vector<std::string> storage;
+        storage.push_back(context.getModuleName());
+        storage.insert(storage.end(), args.begin(), args.end());
+        std::vector<char*> argv;
+        for(std::string& arg : storage) argv.push_back(arg.data());
+        argv.push_back(nullptr);
+        int argc = (int) storage.size();
+
+        auto scope = context.getStats().time("run");
+        switch(mainSignature->returns) {
+            case MainReturn::INT32:
+                return callMain<int32_t>(address, mainSignature->takesArgs, argc, argv.data());
+            // Only the low bits of an exit code survive anyway
+            case MainReturn::INT64:
+                return (int) callMain<int64_t>(address, mainSignature->takesArgs, argc, argv.data());
+            case MainReturn::VOID:
+                callMain<void>(address, mainSignature->takesArgs, argc, argv.data());
+                return 0;
+        }
+        return 0;
+    }
+
+} // namespace nvyc
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CompilationContext.hpp"
+#include "JITObjectCache.hpp"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        In-process execution for -run. Modules from EmissionBuilder::takeModule
+        are added to an ORC LLJIT, and natives (compileNative declarations)
+        resolve against the symbols of the nvyc process itself, so libc and
+        anything linked into the host are callable.
+
+        When lazy, the session is an LLLazyJIT. Each function is compiled on
+        its first call, so time to first instruction depends on what actually
+        runs rather than on the size of the module.
+
+        With a cache directory, compiled objects go through a JITObjectCache,
+        so a repeat run of the same program skips codegen.
+    */
+    class JITSession {
+        private:
+            // How runMain has to call main, read from its FunctionType when its module is added
+            enum class MainReturn {
+                INT32,
+                INT64,
+                VOID
+            };
+
+            struct MainSignature {
+                MainReturn returns = MainReturn::INT32;
+                bool takesArgs = false;   // (int32 argc, argv) rather than ()
+                std::string unsupported;  // Why main can't be called, empty if it can
+            };
+
+            CompilationContext& context;
+            std::unique_ptr<JITObjectCache> cache; // Outlives jit, its compiler holds a pointer
+            std::unique_ptr<llvm::orc::LLJIT> jit;
+            llvm::orc::LLLazyJIT* lazyJit = nullptr; // Same object as jit when lazy
+            std::optional<MainSignature> mainSignature;
+
+            void recordMain(llvm::Module& module);
+
+        public:
+            // Empty cacheDir disables the object cache, cacheBytes bounds its directory
+            JITSession(CompilationContext& ctx, bool lazy = true, const std::string& cacheDir = "", uint64_t cacheBytes = 0);
+
+            JITSession(const JITSession&) = delete;
+            JITSession& operator=(const JITSession&) = delete;
+
+            bool valid() const;
+            bool addModule(llvm::orc::ThreadSafeModule module);
+
+            // Address of a JIT'd or host symbol, nullptr if neither has it
+            void* lookup(const std::string& name);
+
+            // Calls main (under whatever name mangleFunctions gave it) with args as argv[1..]. main may return int32, int64
+            // or void (exit code 0) and take no parameters or (int32, argv), anything else is reported instead of called
+            int runMain(const std::vector<std::string>& args);
+    };
+
+} // namespace nvyc
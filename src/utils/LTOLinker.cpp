@@ -0,0 +1,139 @@
+#include "LTOLinker.hpp"
+#include "EmissionBuilder.hpp"
+#include "error/Error.hpp"
+#include "passes/CompilationPasses.hpp"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/LTO/LTO.h"
+#include "llvm/Support/Caching.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Host.h"
+#include <algorithm>
+#include <memory>
+
+namespace nvyc {
+
+    LTOLinker::LTOLinker(CompilationContext& ctx, LTOMode lto, OptLevel level, unsigned jobs) :
+        context(ctx), mode(lto), level(level), jobs(std::max(jobs, 1u))
+    {}
+
+    void LTOLinker::setTarget(const std::string& targetCPU, const std::string& targetFeatures) {
+        cpu = targetCPU;
+        features = targetFeatures;
+        EmissionBuilder::resolveTarget(cpu, features);
+    }
+
+    void LTOLinker::add(const std::string& name, llvm::SmallVector<char, 0> bitcode, CompilationContext& moduleContext) {
+        inputs.push_back(Input{name, std::move(bitcode)});
+
+        for(const std::string& target : Passes::resolveCallTargets(moduleContext, "main")) {
+            exports.insert(target);
+        }
+        for(const std::string& entry : moduleContext.getEntryPoints()) {
+            for(const std::string& target : Passes::resolveCallTargets(moduleContext, entry)) {
+                exports.insert(target);
+            }
+        }
+        for(const std::string& exported : moduleContext.getExportedFunctions()) {
+            exports.insert(exported);
+        }
+    }
+
+    bool LTOLinker::link(llvm::SmallVectorImpl<char>& out, EmissionBuilder::OutputKind kind) {
+        auto scope = context.getStats().time("lto");
+        EmissionBuilder::initializeNativeTarget();
+
+        // Same target setup as EmissionBuilder::createTargetMachine
+        llvm::lto::Config config;
+        config.CPU = cpu;
+        llvm::SmallVector<llvm::StringRef, 16> attrs;
+        llvm::SplitString(features, attrs, ",");
+        for(llvm::StringRef attr : attrs) config.MAttrs.push_back(attr.str());
+        config.RelocModel = llvm::Reloc::PIC_;
+        config.CGOptLevel = EmissionBuilder::toCodeGenLevel(level);
+        config.OptLevel = level == OptLevel::O0 ? 0 : level == OptLevel::O1 ? 1 : level == OptLevel::O3 ? 3 : 2;
+        config.DefaultTriple = llvm::sys::getDefaultTargetTriple();
+
+        llvm::lto::ThinBackend backend = llvm::lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(jobs));
+        bool archive = kind == EmissionBuilder::OutputKind::ARCHIVE;
+        llvm::lto::LTO lto(std::move(config), backend, mode == LTOMode::FULL && archive ? jobs : 1);
+
+        // First definition wins, the way a linker resolves them in command line order
+        std::unordered_set<std::string> defined;
+        for(const Input& input : inputs) {
+            llvm::MemoryBufferRef buffer(llvm::StringRef(input.bitcode.data(), input.bitcode.size()), input.name);
+            auto file = llvm::lto::InputFile::create(buffer);
+            if(!file) {
+                Error::nvyerr_out("Could not read bitcode for " + input.name + ": " + llvm::toString(file.takeError()));
+                return false;
+            }
+
+            std::vector<llvm::lto::SymbolResolution> resolutions;
+            for(const llvm::lto::InputFile::Symbol& symbol : (*file)->symbols()) {
+                llvm::lto::SymbolResolution resolution;
+                if(!symbol.isUndefined()) {
+                    resolution.Prevailing = defined.insert(symbol.getName().str()).second;
+                    resolution.FinalDefinitionInLinkageUnit = true;
+                }
+                resolution.VisibleToRegularObj = exports.contains(symbol.getName().str());
+                resolutions.push_back(resolution);
+            }
+
+            if(llvm::Error err = lto.add(std::move(*file), resolutions)) {
+                Error::nvyerr_out("Could not add " + input.name + " to LTO: " + llvm::toString(std::move(err)));
+                return false;
+            }
+        }
+
+        // One object per backend task, some tasks (empty partitions) write nothing
+        std::vector<llvm::SmallString<0>> objects(lto.getMaxTasks());
+        auto addStream = [&](unsigned task, const llvm::Twine&) -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+            return std::make_unique<llvm::CachedFileStream>(std::make_unique<llvm::raw_svector_ostream>(objects[task]));
+        };
+
+        if(llvm::Error err = lto.run(addStream)) {
+            Error::nvyerr_out("LTO failed: " + llvm::toString(std::move(err)));
+            return false;
+        }
+
+        std::erase_if(objects, [](const llvm::SmallString<0>& object) { return object.empty(); });
+        context.getStats().addCounter("lto objects", objects.size());
+        if(objects.empty()) {
+            Error::nvyerr_out("LTO produced no code");
+            return false;
+        }
+
+        if(archive) return EmissionBuilder::archiveObjects(objects, context.getModuleName() + ".lto", out);
+
+        // ThinLTO keeps one object per module, which only an archive can hold
+        if(objects.size() > 1) {
+            Error::nvyerr_out("LTO produced " + std::to_string(objects.size()) + " objects, use -emit-a to write them as an archive");
+            return false;
+        }
+        out.assign(objects.front().begin(), objects.front().end());
+        return true;
+    }
+
+    bool LTOLinker::linkFile(const std::string& path, EmissionBuilder::OutputKind kind) {
+        if(kind == EmissionBuilder::OutputKind::ARCHIVE && path.ends_with(".o")) {
+            Error::nvyerr_out("Refusing to write an archive to " + path + ", use a .a name with -emit-a");
+            return false;
+        }
+
+        llvm::SmallVector<char, 0> bytes;
+        if(!link(bytes, kind)) return false;
+
+        std::error_code ec;
+        llvm::raw_fd_ostream file(path, ec, llvm::sys::fs::OF_None);
+        if(ec) {
+            Error::nvyerr_out("Could not open " + path + ": " + ec.message());
+            return false;
+        }
+        file.write(bytes.data(), bytes.size());
+        return true;
+    }
+
+} // namespace nvyc
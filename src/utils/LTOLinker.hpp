@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CompilationContext.hpp"
+#include "CompileOptions.hpp"
+#include "EmissionBuilder.hpp"
+#include "llvm/ADT/SmallVector.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Link-time optimization for -flto=full / -flto=thin over every module of
+        one nvyc invocation. Each module is optimized with the pre-link
+        pipeline and handed over as bitcode (EmissionBuilder::emitBitcode),
+        then llvm::lto::LTO resolves symbols across all of them, optimizes and
+        generates code.
+
+        Full LTO merges everything into one module, so helpers from one module
+        can be inlined into callers in another. ThinLTO keeps the modules
+        separate, imports hot callees using the summaries, and runs the
+        backends in parallel.
+
+        Only main, the modules' entry points and public functions stay visible. Every other
+        definition is internalized, which lets the optimizer drop or
+        specialize it. OBJECT output is one object, so full LTO generates code
+        on one thread. ThinLTO makes one object per module, so OBJECT output
+        only works for a single module: link() fails otherwise, and
+        CompileOptions rejects -flto=thin with several inputs unless -emit-a
+        is given. ARCHIVE (-emit-a) lets full LTO split codegen across jobs
+        and packs every backend's object into an ar archive, as
+        EmissionBuilder does.
+    */
+    class LTOLinker {
+        private:
+            struct Input {
+                std::string name;
+                llvm::SmallVector<char, 0> bitcode; // Must outlive the link, lto::InputFile refers into it
+            };
+
+            CompilationContext& context;
+            LTOMode mode;
+            OptLevel level;
+            unsigned jobs;
+            std::string cpu = "generic";
+            std::string features;
+            std::vector<Input> inputs;
+            std::unordered_set<std::string> exports;
+
+        public:
+            LTOLinker(CompilationContext& ctx, LTOMode lto, OptLevel level, unsigned jobs = 1);
+
+            LTOLinker(const LTOLinker&) = delete;
+            LTOLinker& operator=(const LTOLinker&) = delete;
+
+            // Same meaning as EmissionBuilder::setTarget, the modules' own target attributes still apply per function
+            void setTarget(const std::string& targetCPU, const std::string& targetFeatures);
+
+            // moduleContext supplies the module's exported names (main, entry points, public functions) under their mangled names
+            void add(const std::string& name, llvm::SmallVector<char, 0> bitcode, CompilationContext& moduleContext);
+
+            // kind is OBJECT or ARCHIVE
+            bool link(llvm::SmallVectorImpl<char>& out, EmissionBuilder::OutputKind kind = EmissionBuilder::OutputKind::OBJECT);
+            bool linkFile(const std::string& path, EmissionBuilder::OutputKind kind = EmissionBuilder::OutputKind::OBJECT);
+    };
+
+} // namespace nvyc
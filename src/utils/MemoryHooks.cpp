@@ -0,0 +1,88 @@
+#include "MemoryStats.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/*
+    Replaces the global operator new/delete to feed MemoryStats. Link this
+    file into the nvyc executable only, never into a library, since it would
+    take over the embedder's allocator. Until -fmem-report turns counting on,
+    each call costs one relaxed load on top of malloc/free.
+*/
+
+namespace {
+
+    // Plain thread_local PODs, no constructors, so they are safe to touch from operator new
+    thread_local uint64_t allocationCount = 0;
+    thread_local uint64_t allocatedBytes = 0;
+    thread_local int64_t liveBytes = 0;
+
+    std::atomic<bool> counting{false};
+
+    // The real block size where the allocator reports it, otherwise the size the caller knows (0 if it doesn't)
+    size_t blockSize(void* ptr, size_t requested) {
+#if defined(__GLIBC__)
+        size_t usable = malloc_usable_size(ptr);
+        return usable ? usable : requested;
+#else
+        return requested;
+#endif
+    }
+
+    void* countedAlloc(size_t size) {
+        void* ptr = std::malloc(size ? size : 1);
+        if(!ptr) throw std::bad_alloc();
+        if(!counting.load(std::memory_order_relaxed)) return ptr;
+
+        size_t actual = blockSize(ptr, size);
+        allocationCount++;
+        allocatedBytes += actual;
+        liveBytes += actual;
+        return ptr;
+    }
+
+    void countedFree(void* ptr, size_t size) {
+        if(!ptr) return;
+        if(counting.load(std::memory_order_relaxed)) liveBytes -= blockSize(ptr, size);
+        std::free(ptr);
+    }
+
+    nvyc::MemoryStats::Sample sample() {
+        return nvyc::MemoryStats::Sample{allocationCount, allocatedBytes, liveBytes};
+    }
+
+    void enable() {
+        counting.store(true, std::memory_order_relaxed);
+    }
+
+    const bool registered = (nvyc::MemoryStats::registerHooks(sample, enable), true);
+
+} // namespace
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    countedFree(ptr, 0);
+}
+
+void operator delete[](void* ptr) noexcept {
+    countedFree(ptr, 0);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+    countedFree(ptr, size);
+}
+
+void operator delete[](void* ptr, size_t size) noexcept {
+    countedFree(ptr, size);
+}
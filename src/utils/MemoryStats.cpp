@@ -0,0 +1,48 @@
+#include "MemoryStats.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+    // Set by MemoryHooks.cpp when it is linked in
+    nvyc::MemoryStats::Sample (*sampler)() = nullptr;
+    void (*enabler)() = nullptr;
+
+} // namespace
+
+namespace nvyc::MemoryStats {
+
+    void registerHooks(Sample (*sample)(), void (*enable)()) {
+        sampler = sample;
+        enabler = enable;
+    }
+
+    bool hooksLinked() {
+        return sampler != nullptr;
+    }
+
+    void enableCounting() {
+        if(enabler) enabler();
+    }
+
+    Sample threadSample() {
+        return sampler ? sampler() : Sample();
+    }
+
+    uint64_t peakRssBytes() {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return usage.ru_maxrss;         // Bytes on macOS
+#else
+        return usage.ru_maxrss * 1024;  // Kilobytes on Linux
+#endif
+#else
+        return 0;
+#endif
+    }
+
+} // namespace nvyc::MemoryStats
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace nvyc {
+
+    // Bytes and heap allocations owned by one data structure, for -fmem-report
+    struct MemoryUsage {
+        uint64_t bytes = 0;
+        uint64_t allocations = 0;
+
+        void add(uint64_t size) {
+            bytes += size;
+            allocations++;
+        }
+
+        // Only strings that outgrew the small-string buffer own a heap block
+        void addString(const std::string& str) {
+            static const size_t inlineCapacity = std::string().capacity();
+            if(str.capacity() > inlineCapacity) add(str.capacity() + 1);
+        }
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            bytes += other.bytes;
+            allocations += other.allocations;
+            return *this;
+        }
+    };
+
+    /*
+        Allocation accounting behind -fmem-report. MemoryHooks.cpp, linked into
+        the nvyc executable only, replaces the global operator new/delete to bump
+        thread-local counters once enableCounting() is called, and CompileStats
+        samples them at phase boundaries. Without the hooks every sample is
+        zero and only the structure sizes and peak RSS are reported. Frees are
+        credited to the thread that does them, so a phase can show negative live
+        bytes if it releases memory another phase allocated.
+    */
+    namespace MemoryStats {
+
+        struct Sample {
+            uint64_t allocations = 0;
+            uint64_t allocatedBytes = 0;
+            int64_t liveBytes = 0;
+
+            Sample operator-(const Sample& other) const {
+                return Sample{allocations - other.allocations, allocatedBytes - other.allocatedBytes, liveBytes - other.liveBytes};
+            }
+
+            Sample& operator+=(const Sample& other) {
+                allocations += other.allocations;
+                allocatedBytes += other.allocatedBytes;
+                liveBytes += other.liveBytes;
+                return *this;
+            }
+        };
+
+        // Called once by MemoryHooks.cpp during static initialization
+        void registerHooks(Sample (*sample)(), void (*enable)());
+        bool hooksLinked();
+        void enableCounting();
+
+        Sample threadSample();
+
+        // Process high-water mark, 0 where the platform doesn't report it
+        uint64_t peakRssBytes();
+
+    } // namespace MemoryStats
+
+} // namespace nvyc
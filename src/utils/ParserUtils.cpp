@@ -6,7 +6,6 @@
 #include <string>
 #include <variant>
 #include <memory>
-#include <stack>
 
 using nvyc::NASTNode;
 using nvyc::NodeType;
@@ -49,23 +48,28 @@ namespace nvyc::ParserUtils {
         node.getSubnode(bodyIndex)->addSubnode(std::move(bodyNode));
     }
 
+    uint64_t countNodes(const NASTNode* node) {
+        uint64_t count = 1;
+        for(const auto& subnode : node->getSubnodes()) {
+            if(subnode) count += countNodes(subnode.get());
+        }
+        return count;
+    }
+
+    // Nesting only ever needs a count, and running out of tokens ends the scan instead of spinning
     int moveToMatchingDelimiter(NodeStream& stream, NodeType open, NodeType close) {
-        std::stack<int> stack;
         auto it = stream.iterator();
-        NodeType type;
-        stack.push(1);
+        int nesting = 1;
         size_t distance = 0;
 
-        while(!stack.empty() && it.validNext()) {
-            auto tok = it.get();
-            type = tok.getType();
+        while(nesting > 0 && it.validNext()) {
+            NodeType type = it.get().getType();
 
-            if(type == open) stack.push(1);
-            else if(type == close) stack.pop();
+            if(type == open) nesting++;
+            else if(type == close) nesting--;
 
             distance++;
             it.next();
-        
         }
 
         return distance;
@@ -80,10 +84,12 @@ namespace nvyc::ParserUtils {
         auto functionArgs = createNode(NodeType::FUNCTIONPARAM, NULL_VALUE);
         auto functionReturn = createNode(NodeType::FUNCTIONRETURN, NULL_VALUE);
         auto functionBody = createNode(NodeType::FUNCTIONBODY, NULL_VALUE);
+        auto functionAttributes = createNode(NodeType::DIRECTIVE, NULL_VALUE);
         
         root->addSubnode(std::move(functionArgs));
         root->addSubnode(std::move(functionReturn));
         root->addSubnode(std::move(functionBody));
+        root->addSubnode(std::move(functionAttributes));
 
         return root;
     }
@@ -105,6 +111,35 @@ namespace nvyc::ParserUtils {
         function.getSubnode(FUNCTION_RETURN)->addSubnode(std::move(returnNode));
     }
 
+    // DIRTYPE(name) with one DIRVALUE per argument
+    void addFunctionAttribute(NASTNode& function, std::unique_ptr<NASTNode> attribute) {
+        function.getSubnode(FUNCTION_ATTRIBUTES)->addSubnode(std::move(attribute));
+    }
+
+    // Arguments of the named attribute, empty if the function doesn't have it
+    std::vector<std::string> getFunctionAttribute(const NASTNode& function, const std::string& name) {
+        std::vector<std::string> values;
+        if(function.getSubnodes().size() <= FUNCTION_ATTRIBUTES) return values;
+
+        for(const auto& attribute : function.getSubnode(FUNCTION_ATTRIBUTES)->getSubnodes()) {
+            if(attribute->getData().asString() != name) continue;
+            for(const auto& value : attribute->getSubnodes()) {
+                values.push_back(value->getData().asString());
+            }
+        }
+        return values;
+    }
+
+    // public/private/static, stored with the attributes as nodes of the modifier's type
+    bool hasFunctionModifier(const NASTNode& function, NodeType modifier) {
+        if(function.getSubnodes().size() <= FUNCTION_ATTRIBUTES) return false;
+
+        for(const auto& attribute : function.getSubnode(FUNCTION_ATTRIBUTES)->getSubnodes()) {
+            if(attribute->getType() == modifier) return true;
+        }
+        return false;
+    }
+
     std::unique_ptr<NASTNode> createFunctionCall(const std::string& name) {
         return createNode(NodeType::FUNCTIONCALL, Value(name));
     }
@@ -209,11 +244,13 @@ namespace nvyc::ParserUtils {
         
         // Split variable at '.' such as x.y being var x -> access member y
         std::vector<std::string> elems; 
-        std::stringstream ss(variable);
-        std::string item;
+        size_t start = 0;
 
-        while(std::getline(ss, item, '.')) {
-            elems.push_back(item);
+        while(start <= variable.size()) {
+            size_t dot = variable.find('.', start);
+            if(dot == std::string::npos) dot = variable.size();
+            if(dot > start) elems.push_back(variable.substr(start, dot - start));
+            start = dot + 1;
         }
 
         if(elems.empty()) return nullptr; // Should ideally error if this ever happens
@@ -224,8 +261,9 @@ namespace nvyc::ParserUtils {
 
         for(int i = 1; i < elems.size(); i++) {
             auto memberNode = createNode(NodeType::MEMBER, Value(elems[i]));
+            NASTNode* next = memberNode.get();
             current->addSubnode(std::move(memberNode));
-            current = current->getSubnode(0);
+            current = next;
         }
 
         return root;
@@ -294,29 +332,18 @@ namespace nvyc::ParserUtils {
     }
 
 
+    /*
+        Distance from the current token (a call) to the delimiter closing the
+        one right after it. A lookup in the stream's match table, so nested
+        calls don't rescan their arguments once per level.
+    */
     int getDepth(NodeStream& stream, NodeType open, NodeType close) {
-        std::stack<int> braces;
-        NodeType type;
-        auto it = stream.iterator();
-        it.forward(2);
-        int depth = 2;
-
-        braces.push(1);
-
-        while(!braces.empty()) {
-            auto tok = it.get();
-            type = tok.type;
-            
-            if(type == open) braces.push(1);
-            else if(type == close) braces.pop();
-
-            if(it.validNext() && !braces.empty()) {
-                it.next();
-                depth++;
-            }
-        }
+        int start = stream.getIndex();
+        int closing = stream.getType(start + 1) == open ? stream.matchingDelimiter(start + 1) : -1;
 
-        return depth;
+        // Unbalanced input stops at the last token
+        if(closing < 0 || stream.getType(closing) != close) return stream.size() - 1 - start;
+        return closing - start;
     }
 
 } // namespace nvyc
\ No newline at end of file
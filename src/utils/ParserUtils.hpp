@@ -7,6 +7,7 @@
 #include <string>
 #include <variant>
 #include <memory>
+#include <cstdint>
 
 using nvyc::NASTNode;
 using nvyc::NodeType;
@@ -32,6 +33,7 @@ namespace nvyc::ParserUtils {
     static constexpr int FUNCTION_ARGS = 0;
     static constexpr int FUNCTION_RETURN = 1;
     static constexpr int FUNCTION_BODY = 2;
+    static constexpr int FUNCTION_ATTRIBUTES = 3;
 
     static constexpr int CONDITIONAL_COND = 0;
     static constexpr int CONDITIONAL_BODY = 1;
@@ -53,12 +55,16 @@ namespace nvyc::ParserUtils {
     int getDepth(NodeStream&, NodeType open, NodeType close);
     int moveToMatchingDelimiter(NodeStream& stream, NodeType open, NodeType close);
     std::vector<NodeStream*> getParseList(NodeStream& root);
+    uint64_t countNodes(const NASTNode* node);
 
     // Functions
     std::unique_ptr<NASTNode> createFunction(const std::string& name);
     void addFunctionBody(NASTNode& function, std::unique_ptr<NASTNode> body);
     void addFunctionArg(NASTNode& function, std::unique_ptr<NASTNode> arg);
     void setFunctionReturnType(NASTNode& function, NodeType type);
+    void addFunctionAttribute(NASTNode& function, std::unique_ptr<NASTNode> attribute);
+    std::vector<std::string> getFunctionAttribute(const NASTNode& function, const std::string& name);
+    bool hasFunctionModifier(const NASTNode& function, NodeType modifier);
     
     std::unique_ptr<NASTNode> createFunctionCall(const std::string& name);
     void addFunctionCallArg(NASTNode& function,  std::unique_ptr<NASTNode> arg);
@@ -0,0 +1,153 @@
+#include "PerfCounters.hpp"
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nvyc {
+
+    // ----------------------------------------
+    //                SAMPLES
+    // ----------------------------------------
+
+    PerfSample& PerfSample::operator+=(const PerfSample& other) {
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cacheReferences += other.cacheReferences;
+        cacheMisses += other.cacheMisses;
+        branches += other.branches;
+        branchMisses += other.branchMisses;
+        return *this;
+    }
+
+    PerfSample PerfSample::operator-(const PerfSample& other) const {
+        PerfSample result;
+        result.cycles = cycles - other.cycles;
+        result.instructions = instructions - other.instructions;
+        result.cacheReferences = cacheReferences - other.cacheReferences;
+        result.cacheMisses = cacheMisses - other.cacheMisses;
+        result.branches = branches - other.branches;
+        result.branchMisses = branchMisses - other.branchMisses;
+        return result;
+    }
+
+    double PerfSample::ipc() const {
+        return cycles ? double(instructions) / cycles : 0;
+    }
+
+    double PerfSample::cacheMissRate() const {
+        return cacheReferences ? double(cacheMisses) / cacheReferences : 0;
+    }
+
+    double PerfSample::branchMissRate() const {
+        return branches ? double(branchMisses) / branches : 0;
+    }
+
+
+    // ----------------------------------------
+    //                COUNTERS
+    // ----------------------------------------
+
+    PerfCounters::~PerfCounters() {
+        close();
+    }
+
+    bool PerfCounters::available() const {
+        return groupFd >= 0;
+    }
+
+#if defined(__linux__)
+
+    // Order matches the fields of PerfSample
+    static constexpr uint64_t PERF_EVENTS[] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    bool PerfCounters::open(std::string& error) {
+        close();
+
+        for(uint64_t event : PERF_EVENTS) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = event;
+            attr.disabled = groupFd < 0;    // Leader starts disabled, members follow it
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // pid 0, cpu -1: this thread on any CPU
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+            if(fd < 0) {
+                error = std::strerror(errno);
+                close();
+                return false;
+            }
+
+            if(groupFd < 0) groupFd = fd;
+            fds.push_back(fd);
+        }
+
+        ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+
+    void PerfCounters::close() {
+        for(int fd : fds) ::close(fd);
+        fds.clear();
+        groupFd = -1;
+    }
+
+    PerfSample PerfCounters::read() const {
+        PerfSample sample;
+        if(groupFd < 0) return sample;
+
+        // { nr, time_enabled, time_running, values[nr] }
+        uint64_t buffer[3 + sizeof(PERF_EVENTS) / sizeof(PERF_EVENTS[0])];
+        if(::read(groupFd, buffer, sizeof(buffer)) < (ssize_t) sizeof(buffer)) return sample;
+
+        // Scale up if the group was multiplexed off the PMU part of the time
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+        auto scaled = [&](int i) -> uint64_t {
+            if(running == 0) return 0;
+            return uint64_t(double(buffer[3 + i]) * enabled / running);
+        };
+
+        sample.cycles = scaled(0);
+        sample.instructions = scaled(1);
+        sample.cacheReferences = scaled(2);
+        sample.cacheMisses = scaled(3);
+        sample.branches = scaled(4);
+        sample.branchMisses = scaled(5);
+        return sample;
+    }
+
+#else
+
+    bool PerfCounters::open(std::string& error) {
+        error = "hardware counters are only supported on Linux";
+        return false;
+    }
+
+    void PerfCounters::close() {}
+
+    PerfSample PerfCounters::read() const {
+        return PerfSample();
+    }
+
+#endif
+
+} // namespace nvyc
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nvyc {
+
+    struct PerfSample {
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t cacheReferences = 0;
+        uint64_t cacheMisses = 0;
+        uint64_t branches = 0;
+        uint64_t branchMisses = 0;
+
+        PerfSample& operator+=(const PerfSample& other);
+        PerfSample operator-(const PerfSample& other) const;
+
+        double ipc() const;
+        double cacheMissRate() const;
+        double branchMissRate() const;
+    };
+
+    /*
+        Hardware counters for the calling thread (perf_event_open, Linux only)
+        used by -fperf-counters. Everything is opened as one group so the
+        ratios come from the same scheduling window. When the kernel refuses
+        (perf_event_paranoid, VMs without a PMU, other platforms) open() fails
+        and the compile carries on with timing only.
+    */
+    class PerfCounters {
+        private:
+            int groupFd = -1;
+            std::vector<int> fds;
+
+        public:
+            PerfCounters() {}
+            ~PerfCounters();
+
+            PerfCounters(const PerfCounters&) = delete;
+            PerfCounters& operator=(const PerfCounters&) = delete;
+
+            bool open(std::string& error);
+            void close();
+            bool available() const;
+            PerfSample read() const;
+    };
+
+} // namespace nvyc
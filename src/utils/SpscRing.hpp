@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nvyc {
+
+    /*
+        Bounded single-producer/single-consumer ring. Exactly one thread may
+        push and exactly one other thread may pop. Capacity is rounded up to a
+        power of two. Head and tail live on separate cache lines so the two
+        sides don't false-share.
+
+        push and pop spin for a short while, then sleep on an epoch counter
+        that every successful push or pop (and close) bumps, so a side that
+        is idle for long stops burning a core. close wakes both sides for
+        shutdown.
+    */
+    template<typename T>
+    class SpscRing {
+        private:
+            std::vector<T> slots;
+            size_t mask;
+            alignas(64) std::atomic<size_t> head{0}; // Next slot to pop, written by the consumer
+            alignas(64) std::atomic<size_t> tail{0}; // Next slot to push, written by the producer
+            alignas(64) std::atomic<uint32_t> epoch{0}; // What a blocked side sleeps on
+            std::atomic<bool> closed{false};
+
+            // Yields before falling back to a blocking wait
+            static constexpr int SPIN_LIMIT = 64;
+
+            void signal() {
+                epoch.fetch_add(1, std::memory_order_release);
+                epoch.notify_all();
+            }
+
+            // Epoch is read before retrying, so a signal between the retry and the wait still changes it
+            template<typename Attempt>
+            bool await(Attempt attempt) {
+                for(int i = 0; i < SPIN_LIMIT; i++) {
+                    if(attempt()) return true;
+                    std::this_thread::yield();
+                }
+
+                while(true) {
+                    uint32_t seen = epoch.load(std::memory_order_acquire);
+                    if(attempt()) return true;
+                    if(closed.load(std::memory_order_acquire)) return false;
+                    epoch.wait(seen, std::memory_order_acquire);
+                }
+            }
+
+        public:
+            explicit SpscRing(size_t capacity) {
+                size_t size = 1;
+                while(size < capacity) size <<= 1;
+                slots.resize(size);
+                mask = size - 1;
+            }
+
+            SpscRing(const SpscRing&) = delete;
+            SpscRing& operator=(const SpscRing&) = delete;
+
+            // Leaves value untouched when the ring is full
+            bool tryPush(T& value) {
+                size_t t = tail.load(std::memory_order_relaxed);
+                if(t - head.load(std::memory_order_acquire) == slots.size()) return false;
+
+                slots[t & mask] = std::move(value);
+                tail.store(t + 1, std::memory_order_release);
+                signal();
+                return true;
+            }
+
+            bool tryPop(T& value) {
+                size_t h = head.load(std::memory_order_relaxed);
+                if(h == tail.load(std::memory_order_acquire)) return false;
+
+                value = std::move(slots[h & mask]);
+                head.store(h + 1, std::memory_order_release);
+                signal();
+                return true;
+            }
+
+            // Waits for room, false if the ring was closed first
+            bool push(T& value) {
+                return await([&] { return tryPush(value); });
+            }
+
+            // Waits for a value, false once the ring is closed and drained
+            bool pop(T& value) {
+                return await([&] { return tryPop(value); });
+            }
+
+            // Wakes and fails any blocked push or pop, values already queued can still be popped
+            void close() {
+                closed.store(true, std::memory_order_release);
+                signal();
+            }
+
+            size_t capacity() const {
+                return slots.size();
+            }
+    };
+
+} // namespace nvyc
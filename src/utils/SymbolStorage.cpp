@@ -3,55 +3,214 @@
 
 namespace nvyc {
 
-    llvm::Value* SymbolStorage::getAlloca(const std::string& variable) {
-        auto it = variableAlloca.find(variable);
-        if(it != variableAlloca.end()) {
-            return it->second;
+    SymbolId SymbolStorage::intern(const std::string& name) {
+        auto [it, inserted] = ids.try_emplace(name, (SymbolId) names.size());
+        if(inserted) {
+            names.push_back(name);
+            table.emplace_back();
         }
-        nvyc::Error::nvyerr_out("Invalid map request for variable " + variable);
-        return nullptr;
+        return it->second;
     }
 
-    void SymbolStorage::storeAlloca(const std::string variable, llvm::Value* value) {
-        variableAlloca[variable] = value;
+    const std::string& SymbolStorage::nameOf(SymbolId id) const {
+        return names.at(id);
     }
 
-    NodeType SymbolStorage::getVarNvyType(const std::string& variable) {
-        auto it = variableTypes.find(variable);
-        if(it != variableTypes.end()) {
-            return it->second.first;
+
+    // ----------------------------------------
+    //                 SCOPES
+    // ----------------------------------------
+
+    void SymbolStorage::pushScope() {
+        scopes.push_back(shadowed.size());
+    }
+
+    // Restores in reverse, so a name redefined twice in one scope gets its outer binding back
+    void SymbolStorage::popScope() {
+        if(scopes.empty()) {
+            nvyc::Error::nvyerr_out("Attempted to pop the global scope");
+            return;
+        }
+
+        size_t start = scopes.back();
+        scopes.pop_back();
+        for(size_t i = shadowed.size(); i > start; i--) {
+            auto& [id, variable] = shadowed[i - 1];
+            table[id].variable = variable;
         }
-        nvyc::Error::nvyerr_out("Invalid type request for variable " + variable);
-        return NodeType::INVALID;
+        shadowed.resize(start);
     }
 
-    llvm::Type* SymbolStorage::getVarNativeType(const std::string& variable) {
-        auto it = variableTypes.find(variable);
-        if(it != variableTypes.end()) {
-            return it->second.second;
+    size_t SymbolStorage::scopeDepth() const {
+        return scopes.size();
+    }
+
+    // The binding to write for a definition in the current scope, saving the outer one first
+    SymbolStorage::Variable& SymbolStorage::define(SymbolId id) {
+        Variable& variable = table[id].variable;
+        uint32_t depth = (uint32_t) scopes.size();
+        if(variable.depth != depth) {
+            if(depth > 0) shadowed.emplace_back(id, variable);
+            variable = Variable();
+            variable.depth = depth;
         }
-        nvyc::Error::nvyerr_out("Invalid type request for variable " + variable);
-        return nullptr;
+        return variable;
+    }
+
+
+    // ----------------------------------------
+    //               VARIABLES
+    // ----------------------------------------
+
+    llvm::Value* SymbolStorage::getAlloca(SymbolId variable) {
+        llvm::Value* value = table[variable].variable.alloca;
+        if(!value) nvyc::Error::nvyerr_out("Invalid map request for variable " + names[variable]);
+        return value;
+    }
+
+    llvm::Value* SymbolStorage::getAlloca(const std::string& variable) {
+        return getAlloca(intern(variable));
+    }
+
+    void SymbolStorage::storeAlloca(SymbolId variable, llvm::Value* value) {
+        Variable& binding = define(variable);
+        binding.alloca = value;
+        binding.ssa = nullptr; // Memory now shadows any SSA binding of the same name
+    }
+
+    void SymbolStorage::storeAlloca(const std::string& variable, llvm::Value* value) {
+        storeAlloca(intern(variable), value);
+    }
+
+    NodeType SymbolStorage::getVarNvyType(SymbolId variable) {
+        NodeType type = table[variable].variable.nvyType;
+        if(type == NodeType::INVALID) nvyc::Error::nvyerr_out("Invalid type request for variable " + names[variable]);
+        return type;
+    }
+
+    NodeType SymbolStorage::getVarNvyType(const std::string& variable) {
+        return getVarNvyType(intern(variable));
+    }
+
+    llvm::Type* SymbolStorage::getVarNativeType(SymbolId variable) {
+        llvm::Type* type = table[variable].variable.llvmType;
+        if(!type) nvyc::Error::nvyerr_out("Invalid type request for variable " + names[variable]);
+        return type;
+    }
+
+    llvm::Type* SymbolStorage::getVarNativeType(const std::string& variable) {
+        return getVarNativeType(intern(variable));
+    }
+
+    void SymbolStorage::storeVarType(SymbolId variable, NodeType type, llvm::Type* ty) {
+        Variable& binding = define(variable);
+        binding.nvyType = type;
+        binding.llvmType = ty;
+    }
+
+    void SymbolStorage::storeVarType(const std::string& variable, NodeType type, llvm::Type* ty) {
+        storeVarType(intern(variable), type, ty);
+    }
+
+    llvm::Value* SymbolStorage::getSSA(SymbolId variable) {
+        return table[variable].variable.ssa;
+    }
+
+    llvm::Value* SymbolStorage::getSSA(const std::string& variable) {
+        return getSSA(intern(variable));
+    }
+
+    bool SymbolStorage::isSSA(const std::string& variable) {
+        return getSSA(variable) != nullptr;
+    }
+
+    void SymbolStorage::storeSSA(SymbolId variable, llvm::Value* value) {
+        Variable& binding = define(variable);
+        binding.ssa = value;
+        binding.alloca = nullptr;
     }
 
-    void SymbolStorage::storeVarType(const std::string variable, NodeType type, llvm::Type* ty) {
-        variableTypes[variable] = makePair(type, ty);
+    void SymbolStorage::storeSSA(const std::string& variable, llvm::Value* value) {
+        storeSSA(intern(variable), value);
+    }
+
+    bool SymbolStorage::escapes(SymbolId variable) {
+        return allEscaping || table[variable].escapeGeneration == escapeGeneration;
+    }
+
+    bool SymbolStorage::escapes(const std::string& variable) {
+        return escapes(intern(variable));
+    }
+
+    void SymbolStorage::markEscaping(const std::string& variable) {
+        table[intern(variable)].escapeGeneration = escapeGeneration;
+    }
+
+    void SymbolStorage::markAllEscaping() {
+        allEscaping = true;
+    }
+
+    // Escape information is per function, a new generation forgets the last one without touching the table
+    void SymbolStorage::clearEscaping() {
+        escapeGeneration++;
+        allEscaping = false;
+    }
+
+
+    // ----------------------------------------
+    //               FUNCTIONS
+    // ----------------------------------------
+
+    NodeType SymbolStorage::getFunType(SymbolId func) {
+        NodeType type = table[func].functionType;
+        if(type == NodeType::INVALID) nvyc::Error::nvyerr_out("Invalid map request for variable " + names[func]);
+        return type;
     }
 
     NodeType SymbolStorage::getFunType(const std::string& func) {
-        auto it = functionTypes.find(func);
-        if(it != functionTypes.end()) {
-            return it->second;
-        }
-        nvyc::Error::nvyerr_out("Invalid map request for variable " + func);
-        return NodeType::INVALID;
+        return getFunType(intern(func));
+    }
+
+    void SymbolStorage::storeFunType(const std::string& func, NodeType type) {
+        table[intern(func)].functionType = type;
     }
-    void SymbolStorage::storeFunType(const std::string func, NodeType type) {
-        functionTypes[func] = type;
+
+    llvm::FunctionCallee SymbolStorage::getFunction(SymbolId func) {
+        return table[func].function;
     }
 
+    llvm::FunctionCallee SymbolStorage::getFunction(const std::string& func) {
+        return getFunction(intern(func));
+    }
+
+    void SymbolStorage::storeFunction(const std::string& func, llvm::FunctionCallee callee) {
+        table[intern(func)].function = callee;
+    }
+
+    // Callees belong to a module, return types outlive it
+    void SymbolStorage::clearFunctions() {
+        for(Symbol& symbol : table) symbol.function = llvm::FunctionCallee();
+    }
+
+
+    /*
+        The interner is estimated from the node-based layout of unordered_map:
+        one bucket array plus one node (key, ID and next pointer/hash) per entry.
+        The tables are counted by capacity, since that is what they keep between functions.
+    */
+    MemoryUsage SymbolStorage::memoryUsage() const {
+        MemoryUsage usage;
+        usage.add(ids.bucket_count() * sizeof(void*));
+        for(const auto& entry : ids) {
+            usage.add(sizeof(entry) + 2 * sizeof(void*));
+            usage.addString(entry.first);
+        }
 
-    std::pair<NodeType, llvm::Type*> SymbolStorage::makePair(NodeType type, llvm::Type* ty) {
-        return std::pair<NodeType, llvm::Type*>(type, ty);
+        usage.add(names.capacity() * sizeof(std::string));
+        for(const std::string& name : names) usage.addString(name);
+        usage.add(table.capacity() * sizeof(Symbol));
+        usage.add(shadowed.capacity() * sizeof(std::pair<SymbolId, Variable>));
+        usage.add(scopes.capacity() * sizeof(size_t));
+        return usage;
     }
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "data/NodeType.hpp"
+#include "utils/MemoryStats.hpp"
 #include <unordered_map>
 #include <string>
 #include <utility>
+#include <vector>
+#include <cstdint>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Function.h>
 
@@ -11,30 +14,100 @@ using nvyc::NodeType;
 
 namespace nvyc {
 
+    // Interned name, index into SymbolStorage's tables
+    using SymbolId = uint32_t;
+    inline constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+    /*
+        Names are interned once into dense IDs, and every table is a vector
+        indexed by ID, so a lookup is one index instead of a string hash.
+        Emission caches the ID on the AST node (EmissionBuilder::symbolOf).
+
+        Variables are scoped. Each ID holds the binding visible right now.
+        Defining a name that was bound in an outer scope saves the old
+        binding to a log, and popScope puts logged bindings back, so push
+        and pop cost only the names the scope defined. The vectors keep
+        their capacity, so one function's storage is reused by the next.
+        Depth 0 is the global scope and is never popped.
+
+        Functions are module wide and not scoped.
+    */
     class SymbolStorage {
     private:
-        std::unordered_map<std::string, llvm::Value*> variableAlloca;
-        std::unordered_map<std::string, llvm::Function*> functionData;
-        std::unordered_map<std::string, std::pair<NodeType, llvm::Type*>> variableTypes;
-        std::unordered_map<std::string, NodeType> functionTypes;
+        struct Variable {
+            llvm::Value* alloca = nullptr;
+            // Locals whose address is never taken are kept as SSA values instead of allocas
+            llvm::Value* ssa = nullptr;
+            NodeType nvyType = NodeType::INVALID;
+            llvm::Type* llvmType = nullptr;
+            uint32_t depth = 0; // Scope that made this binding
+        };
+
+        struct Symbol {
+            Variable variable;
+            uint32_t escapeGeneration = 0; // Escapes if equal to the current generation
+            llvm::FunctionCallee function;
+            NodeType functionType = NodeType::INVALID;
+        };
+
+        std::unordered_map<std::string, SymbolId> ids;
+        std::vector<std::string> names;
+        std::vector<Symbol> table;
+
+        // Bindings hidden by an inner scope, and where each open scope starts in that log
+        std::vector<std::pair<SymbolId, Variable>> shadowed;
+        std::vector<size_t> scopes;
+
+        uint32_t escapeGeneration = 1;
+        bool allEscaping = false;
+
+        Variable& define(SymbolId id);
 
-        std::pair<NodeType, llvm::Type*> makePair(NodeType type, llvm::Type* ty);
-        
     public:
         SymbolStorage() {}
 
+        SymbolId intern(const std::string& name);
+        const std::string& nameOf(SymbolId id) const;
+
+        void pushScope();
+        void popScope();
+        size_t scopeDepth() const;
+
+        llvm::Value* getAlloca(SymbolId variable);
         llvm::Value* getAlloca(const std::string& variable);
-        void storeAlloca(const std::string variable, llvm::Value* value);
+        void storeAlloca(SymbolId variable, llvm::Value* value);
+        void storeAlloca(const std::string& variable, llvm::Value* value);
 
+        NodeType getVarNvyType(SymbolId variable);
         NodeType getVarNvyType(const std::string& variable);
+        llvm::Type* getVarNativeType(SymbolId variable);
         llvm::Type* getVarNativeType(const std::string& variable);
-        void storeVarType(const std::string variable, NodeType type, llvm::Type* ty);
+        void storeVarType(SymbolId variable, NodeType type, llvm::Type* ty);
+        void storeVarType(const std::string& variable, NodeType type, llvm::Type* ty);
 
+        llvm::Value* getSSA(SymbolId variable);
+        llvm::Value* getSSA(const std::string& variable);
+        bool isSSA(const std::string& variable);
+        void storeSSA(SymbolId variable, llvm::Value* value);
+        void storeSSA(const std::string& variable, llvm::Value* value);
+
+        bool escapes(SymbolId variable);
+        bool escapes(const std::string& variable);
+        void markEscaping(const std::string& variable);
+        void markAllEscaping();
+        void clearEscaping();
+
+        NodeType getFunType(SymbolId func);
         NodeType getFunType(const std::string& func);
-        void storeFunType(const std::string func, NodeType type);
+        void storeFunType(const std::string& func, NodeType type);
+
+        // Callee of a function of the current module, empty if it has none
+        llvm::FunctionCallee getFunction(SymbolId func);
+        llvm::FunctionCallee getFunction(const std::string& func);
+        void storeFunction(const std::string& func, llvm::FunctionCallee callee);
+        void clearFunctions();
 
-        //llvm::Function* getFunction(const std::string& func);
-        //void storeFunction(const std::string& func, llvm::Function* fptr);
+        MemoryUsage memoryUsage() const;
     };
 
 }
@@ -0,0 +1,33 @@
+#include "TimeTrace.hpp"
+#include "error/Error.hpp"
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/Error.h>
+
+namespace nvyc::TimeTrace {
+
+    void beginThread(const std::string& processName, unsigned granularityUs) {
+        llvm::timeTraceProfilerInitialize(granularityUs, processName);
+    }
+
+    void finishThread() {
+        if(llvm::timeTraceProfilerEnabled()) llvm::timeTraceProfilerFinishThread();
+    }
+
+    bool enabled() {
+        return llvm::timeTraceProfilerEnabled();
+    }
+
+    bool write(const std::string& path) {
+        if(!llvm::timeTraceProfilerEnabled()) return false;
+
+        llvm::Error err = llvm::timeTraceProfilerWrite(path, "nvyc");
+        llvm::timeTraceProfilerCleanup();
+
+        if(err) {
+            nvyc::Error::nvyerr_out("Failed to write time trace to " + path + ": " + llvm::toString(std::move(err)));
+            return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace nvyc::TimeTrace {
+
+    /*
+        Thin wrapper over LLVM's time trace profiler for -ftime-trace.
+        Every thread that compiles calls beginThread() first, worker threads
+        call finishThread() before exiting, and the thread that started the
+        compile writes the Chrome/Perfetto JSON once all workers are joined.
+        Spans from CompileStats::Scope, the parser, the emitter and LLVM's
+        passes all land in the same file, one lane per thread.
+    */
+
+    static constexpr unsigned DEFAULT_GRANULARITY_US = 500;
+
+    void beginThread(const std::string& processName, unsigned granularityUs = DEFAULT_GRANULARITY_US);
+    void finishThread();
+    bool enabled();
+    bool write(const std::string& path);
+
+}
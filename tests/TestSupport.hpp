@@ -0,0 +1,30 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+/*
+    Checks shared by the test executables under tests/. Like
+    bench/nvyc_bench.cpp, each test is its own main() built against the
+    compiler sources. It reports every failed check and exits non-zero if
+    any failed.
+*/
+namespace nvyc::test {
+
+    inline int failures = 0;
+
+    inline void check(bool ok, const char* expression, const char* file, int line) {
+        if(ok) return;
+        failures++;
+        std::cerr << file << ":" << line << ": check failed: " << expression << "\n";
+    }
+
+    inline int finish(const std::string& suite) {
+        if(failures) std::cerr << suite << ": " << failures << " check(s) failed\n";
+        else std::cerr << suite << ": ok\n";
+        return failures ? 1 : 0;
+    }
+
+} // namespace nvyc::test
+
+#define NVY_CHECK(expr) nvyc::test::check((expr), #expr, __FILE__, __LINE__)
@@ -0,0 +1,210 @@
+#include "TestSupport.hpp"
+#include "generation/Lexer.hpp"
+#include "generation/Parser.hpp"
+#include "generation/LLVMEmission.hpp"
+#include "passes/PassManager.hpp"
+#include "processing/StreamRebuilder.hpp"
+#include "utils/CompilationContext.hpp"
+#include "utils/CompileStats.hpp"
+#include "utils/EmissionBuilder.hpp"
+#include "utils/MemoryStats.hpp"
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/*
+    Pathological front-end inputs at N, 2N, 4N and 8N: deep parenthesis
+    nesting, nested calls, long argument lists, long x.y.z member chains
+    and thousands of tokens on one line. Per phase, the log-log slope of
+    time (best of a few runs) and of bytes allocated against N has to stay
+    near 1. Anything that rescans its input per construct, such as once per
+    enclosing call, fits close to 2.
+
+    The byte counts come from the allocation hooks, so this test has to be
+    linked with src/utils/MemoryHooks.cpp.
+*/
+
+using nvyc::NASTNode;
+using nvyc::NodeType;
+
+namespace {
+
+    // Linear or n log n with headroom for timer noise, quadratic fits come out near 2
+    constexpr double MAX_EXPONENT = 1.35;
+    constexpr int REPEATS = 3;
+    const std::vector<int> SCALES = {1, 2, 4, 8};
+
+    const std::vector<std::string> FRONT_END = {"lex", "lexicalPasses", "parse"};
+    const std::vector<std::string> PIPELINE = {"lex", "lexicalPasses", "parse", "parsingPasses", "compilationPasses", "emit"};
+
+    // The parser logs to stdout
+    class NullBuffer : public std::streambuf {
+        protected:
+            int overflow(int c) override { return c; }
+    };
+
+    struct Family {
+        std::string name;
+        std::string (*expression)(int n);
+        int base;
+        bool calls; // Needs FUNCTIONCALL tokens, see resolveCalls
+        bool emit;  // Whole pipeline, otherwise the front end only
+    };
+
+    struct Cost {
+        double ms;
+        double bytes;
+    };
+
+    // public func f(int32 a, int32 b) -> int32 { let x = <expression>; return x; }
+    std::vector<std::string> program(const std::string& expression) {
+        return {
+            "public func f(int32 a, int32 b) -> int32 {",
+            "    let x = " + expression + ";",
+            "    return x;",
+            "}"
+        };
+    }
+
+    // ((((a + b) * a) + b) ...) n deep
+    std::string parenNesting(int n) {
+        std::string expr = "a";
+        for(int i = 0; i < n; i++) expr = "(" + expr + (i % 2 ? " * a)" : " + b)");
+        return expr;
+    }
+
+    // g(g(g(a, b), b), b) n deep
+    std::string nestedCalls(int n) {
+        std::string expr = "a";
+        for(int i = 0; i < n; i++) expr = "g(" + expr + ", b)";
+        return expr;
+    }
+
+    // g(a, b, a, ...) with n arguments
+    std::string argumentList(int n) {
+        std::string expr = "g(a";
+        for(int i = 1; i < n; i++) expr += i % 2 ? ", b" : ", a";
+        return expr + ")";
+    }
+
+    // a.m0.m1 ... m<n-1>
+    std::string memberChain(int n) {
+        std::string expr = "a";
+        for(int i = 0; i < n; i++) expr += ".m" + std::to_string(i);
+        return expr;
+    }
+
+    // a + b - a + ... with n operands, all on the one line
+    std::string longLine(int n) {
+        static const char* ops[] = {" + ", " - ", " * "};
+        std::string expr = "a";
+        for(int i = 1; i < n; i++) expr += std::string(ops[i % 3]) + (i % 2 ? "b" : "a");
+        return expr;
+    }
+
+    // What LexerCleaner's resolveFunctionCalls did before it was commented out: name( outside a declaration is a call
+    void resolveCalls(nvyc::NodeStream& stream) {
+        for(int i = 1; i + 1 < stream.size(); i++) {
+            if(stream.getType(i) != NodeType::VARIABLE || stream.getType(i + 1) != NodeType::OPENPARENS) continue;
+            if(stream.getType(i - 1) == NodeType::FUNCTION) continue;
+
+            auto token = stream.getToken(i);
+            token.type = NodeType::FUNCTIONCALL;
+            stream.setToken(token, i);
+        }
+    }
+
+    // Top-level phases of one compilation
+    std::map<std::string, Cost> compileOnce(const Family& family, std::vector<std::string> lines) {
+        nvyc::CompilationContext context("complexity");
+        context.getStats().enableTiming(nvyc::CompileStats::Format::JSON);
+        context.getStats().enableMemory();
+        {
+            nvyc::Processing::StreamRebuilder rebuilder(lines);
+            nvyc::Passes::PassManager passes(context, rebuilder);
+
+            std::unique_ptr<nvyc::NodeStream> stream(nvyc::Lexer::getInstance().lex(context, lines));
+            passes.executeLexicalPasses(*stream);
+            if(family.calls) resolveCalls(*stream);
+
+            nvyc::Parser parser(context);
+            std::vector<std::unique_ptr<NASTNode>> nodes = parser.parseStream(*stream);
+            stream.reset();
+
+            if(family.emit) {
+                for(auto& node : nodes) {
+                    node = passes.executeParsingPasses(std::move(node));
+                }
+                passes.executeCompilationPasses(nodes);
+
+                nvyc::EmissionBuilder builder(context, "complexity");
+                nvyc::compile(&builder, nodes);
+            }
+        }
+
+        std::map<std::string, Cost> costs;
+        for(const auto& phase : context.getStats().getPhases()) {
+            if(phase.depth != 0) continue;
+            costs[phase.name].ms += phase.wallMs;
+            costs[phase.name].bytes += phase.memory.allocatedBytes;
+        }
+        return costs;
+    }
+
+    void checkLinear(const Family& family) {
+        const std::vector<std::string>& phases = family.emit ? PIPELINE : FRONT_END;
+        std::map<std::string, std::vector<std::pair<double, double>>> times, bytes;
+
+        for(int scale : SCALES) {
+            int n = family.base * scale;
+            std::vector<std::string> lines = program(family.expression(n));
+
+            // Allocations are the same every run, only the time is noisy
+            std::map<std::string, Cost> best;
+            for(int r = 0; r < REPEATS; r++) {
+                for(const auto& [phase, cost] : compileOnce(family, lines)) {
+                    auto it = best.find(phase);
+                    if(it == best.end() || cost.ms < it->second.ms) best[phase] = cost;
+                }
+            }
+
+            for(const std::string& phase : phases) {
+                NVY_CHECK(best.count(phase));
+                times[phase].emplace_back(n, best[phase].ms);
+                bytes[phase].emplace_back(n, best[phase].bytes);
+            }
+        }
+
+        for(const std::string& phase : phases) {
+            double time = nvyc::CompileStats::scalingExponent(times[phase]);
+            double memory = nvyc::CompileStats::scalingExponent(bytes[phase]);
+            std::cerr << family.name << " " << phase << ": time exponent " << time << ", memory exponent " << memory << "\n";
+            NVY_CHECK(time <= MAX_EXPONENT);
+            NVY_CHECK(memory <= MAX_EXPONENT);
+        }
+    }
+
+}
+
+int main() {
+    NVY_CHECK(nvyc::MemoryStats::hooksLinked());
+
+    NullBuffer null;
+    std::streambuf* out = std::cout.rdbuf(&null);
+
+    const std::vector<Family> families = {
+        {"parenNesting", parenNesting, 1000, false, true},
+        {"nestedCalls", nestedCalls, 1000, true, false},
+        {"argumentList", argumentList, 2000, true, false},
+        {"memberChain", memberChain, 2000, false, false},
+        {"longLine", longLine, 1000, false, true}
+    };
+    for(const Family& family : families) checkLinear(family);
+
+    std::cout.rdbuf(out);
+    return nvyc::test::finish("test_complexity");
+}
@@ -0,0 +1,94 @@
+#include "TestSupport.hpp"
+#include "passes/CompilationPasses.hpp"
+#include "utils/CompilationContext.hpp"
+#include "utils/ParserUtils.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    Passes::eliminateDeadFunctions: which definitions survive with and
+    without roots (main, entry points, public functions).
+*/
+
+using nvyc::NASTNode;
+
+namespace {
+
+    // func name() { callee(); ... }
+    std::unique_ptr<NASTNode> function(const std::string& name, const std::vector<std::string>& callees = {}) {
+        auto node = nvyc::ParserUtils::createFunction(name);
+        for(const std::string& callee : callees) {
+            nvyc::ParserUtils::addFunctionBody(*node, nvyc::ParserUtils::createFunctionCall(callee));
+        }
+        return node;
+    }
+
+    std::vector<std::unique_ptr<NASTNode>> program(std::vector<std::unique_ptr<NASTNode>> functions) {
+        auto module = nvyc::ParserUtils::createModule("test");
+        for(auto& node : functions) module->addSubnode(std::move(node));
+
+        std::vector<std::unique_ptr<NASTNode>> nodes;
+        nodes.push_back(std::move(module));
+        return nodes;
+    }
+
+    std::vector<std::string> remaining(const std::vector<std::unique_ptr<NASTNode>>& nodes) {
+        std::vector<std::string> names;
+        for(const auto& subnode : nodes.front()->getSubnodes()) names.push_back(subnode->getData().asString());
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::vector<std::unique_ptr<NASTNode>> build(std::initializer_list<std::pair<std::string, std::vector<std::string>>> functions) {
+        std::vector<std::unique_ptr<NASTNode>> nodes;
+        for(const auto& [name, callees] : functions) nodes.push_back(function(name, callees));
+        return program(std::move(nodes));
+    }
+
+    // Library build, nothing is a root so nothing may be removed
+    void noMain() {
+        nvyc::CompilationContext context("test");
+        auto nodes = build({{"f", {"g"}}, {"g", {}}, {"h", {}}});
+
+        NVY_CHECK(!nvyc::Passes::eliminateDeadFunctions(context, nodes));
+        NVY_CHECK(remaining(nodes) == std::vector<std::string>({"f", "g", "h"}));
+    }
+
+    // Entry points that are not defined in this compilation are not roots either
+    void undefinedEntryPoint() {
+        nvyc::CompilationContext context("test");
+        context.getEntryPoints().insert("missing");
+        auto nodes = build({{"f", {}}, {"g", {}}});
+
+        NVY_CHECK(!nvyc::Passes::eliminateDeadFunctions(context, nodes));
+        NVY_CHECK(remaining(nodes) == std::vector<std::string>({"f", "g"}));
+    }
+
+    void fromMain() {
+        nvyc::CompilationContext context("test");
+        auto nodes = build({{"main", {"f"}}, {"f", {"g"}}, {"g", {}}, {"h", {}}});
+
+        NVY_CHECK(nvyc::Passes::eliminateDeadFunctions(context, nodes));
+        NVY_CHECK(remaining(nodes) == std::vector<std::string>({"f", "g", "main"}));
+    }
+
+    void fromPublic() {
+        nvyc::CompilationContext context("test");
+        context.getExportedFunctions().insert("api");
+        auto nodes = build({{"api", {"helper"}}, {"helper", {}}, {"unused", {}}});
+
+        NVY_CHECK(nvyc::Passes::eliminateDeadFunctions(context, nodes));
+        NVY_CHECK(remaining(nodes) == std::vector<std::string>({"api", "helper"}));
+    }
+
+}
+
+int main() {
+    noMain();
+    undefinedEntryPoint();
+    fromMain();
+    fromPublic();
+    return nvyc::test::finish("test_dead_functions");
+}
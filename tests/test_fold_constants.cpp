@@ -0,0 +1,106 @@
+#include "TestSupport.hpp"
+#include "passes/ParserPasses.hpp"
+#include "utils/ParserUtils.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+/*
+    Passes::foldConstants on single binary expressions: wrapping integer
+    arithmetic, divisions left to runtime, numeric promotion, and operands
+    that are literals but not numbers.
+*/
+
+using nvyc::NASTNode;
+using nvyc::NodeType;
+using nvyc::Value;
+
+namespace {
+
+    std::unique_ptr<NASTNode> literal(int32_t v) { return nvyc::ParserUtils::createNode(NodeType::INT32, Value(v)); }
+    std::unique_ptr<NASTNode> literal(int64_t v) { return nvyc::ParserUtils::createNode(NodeType::INT64, Value(v)); }
+    std::unique_ptr<NASTNode> literal(float v)   { return nvyc::ParserUtils::createNode(NodeType::FP32, Value(v)); }
+    std::unique_ptr<NASTNode> literal(double v)  { return nvyc::ParserUtils::createNode(NodeType::FP64, Value(v)); }
+
+    std::unique_ptr<NASTNode> binary(NodeType op, std::unique_ptr<NASTNode> lhs, std::unique_ptr<NASTNode> rhs) {
+        auto node = nvyc::ParserUtils::createNode(op, nvyc::NULL_VALUE);
+        node->addSubnode(std::move(lhs));
+        node->addSubnode(std::move(rhs));
+        return nvyc::Passes::foldConstants(std::move(node));
+    }
+
+    void integerOverflow() {
+        auto i32 = binary(NodeType::ADD, literal(std::numeric_limits<int32_t>::max()), literal(int32_t(1)));
+        NVY_CHECK(i32->getType() == NodeType::INT32);
+        NVY_CHECK(i32->getData().i32 == std::numeric_limits<int32_t>::min());
+
+        auto mul = binary(NodeType::MUL, literal(int32_t(65536)), literal(int32_t(65536)));
+        NVY_CHECK(mul->getType() == NodeType::INT32);
+        NVY_CHECK(mul->getData().i32 == 0);
+
+        auto i64 = binary(NodeType::SUB, literal(std::numeric_limits<int64_t>::min()), literal(int64_t(1)));
+        NVY_CHECK(i64->getType() == NodeType::INT64);
+        NVY_CHECK(i64->getData().i64 == std::numeric_limits<int64_t>::max());
+    }
+
+    void divisionByZero() {
+        // Integer traps stay in the tree for runtime
+        auto zero = binary(NodeType::DIV, literal(int32_t(7)), literal(int32_t(0)));
+        NVY_CHECK(zero->getType() == NodeType::DIV);
+        NVY_CHECK(zero->getSubnodes().size() == 2);
+
+        auto overflow = binary(NodeType::DIV, literal(std::numeric_limits<int32_t>::min()), literal(int32_t(-1)));
+        NVY_CHECK(overflow->getType() == NodeType::DIV);
+
+        auto wide = binary(NodeType::DIV, literal(int64_t(7)), literal(int64_t(0)));
+        NVY_CHECK(wide->getType() == NodeType::DIV);
+
+        // Floating point division is defined, it folds to infinity
+        auto fp = binary(NodeType::DIV, literal(1.0), literal(0.0));
+        NVY_CHECK(fp->getType() == NodeType::FP64);
+        NVY_CHECK(std::isinf(fp->getData().f64));
+
+        auto exact = binary(NodeType::DIV, literal(int32_t(-7)), literal(int32_t(2)));
+        NVY_CHECK(exact->getType() == NodeType::INT32);
+        NVY_CHECK(exact->getData().i32 == -3);
+    }
+
+    void mixedPromotion() {
+        auto intDouble = binary(NodeType::ADD, literal(int32_t(1)), literal(2.5));
+        NVY_CHECK(intDouble->getType() == NodeType::FP64);
+        NVY_CHECK(intDouble->getData().f64 == 3.5);
+
+        auto longFloat = binary(NodeType::MUL, literal(int64_t(3)), literal(0.5f));
+        NVY_CHECK(longFloat->getType() == NodeType::FP32);
+        NVY_CHECK(longFloat->getData().f32 == 1.5f);
+
+        auto intLong = binary(NodeType::ADD, literal(int32_t(-1)), literal(int64_t(1) << 40));
+        NVY_CHECK(intLong->getType() == NodeType::INT64);
+        NVY_CHECK(intLong->getData().i64 == (int64_t(1) << 40) - 1);
+
+        auto floatDouble = binary(NodeType::SUB, literal(1.5f), literal(0.25));
+        NVY_CHECK(floatDouble->getType() == NodeType::FP64);
+        NVY_CHECK(floatDouble->getData().f64 == 1.25);
+    }
+
+    // "a" + 1 has to reach the emitter's type error untouched
+    void nonNumericLiterals() {
+        auto str = binary(NodeType::ADD, nvyc::ParserUtils::createNode(NodeType::STR, Value(std::string("a"))), literal(int32_t(1)));
+        NVY_CHECK(str->getType() == NodeType::ADD);
+        NVY_CHECK(str->getSubnodes().size() == 2);
+        NVY_CHECK(str->getSubnode(0)->getType() == NodeType::STR);
+
+        auto identity = binary(NodeType::ADD, nvyc::ParserUtils::createNode(NodeType::STR, Value(std::string("a"))), literal(int32_t(0)));
+        NVY_CHECK(identity->getType() == NodeType::ADD);
+    }
+
+}
+
+int main() {
+    integerOverflow();
+    divisionByZero();
+    mixedPromotion();
+    nonNumericLiterals();
+    return nvyc::test::finish("test_fold_constants");
+}
@@ -0,0 +1,141 @@
+#include "TestSupport.hpp"
+#include "data/NodeStream.hpp"
+#include "generation/Lexer.hpp"
+#include "generation/LexerStream.hpp"
+#include "utils/CompilationContext.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    LexerStream's declaration boundaries: a struct with a trailing ';', a
+    '}' whose ';' is on the next line, a last declaration cut off by EOF
+    and a module block kept whole. Every case runs inline and threaded, and
+    the declarations put together have to be exactly the whole-file lex.
+    The threaded stream is also destroyed with the producer blocked on a
+    full ring, which only returns if SpscRing::close wakes it.
+*/
+
+using nvyc::NodeStream;
+using nvyc::NodeType;
+
+namespace {
+
+    std::vector<NodeType> types(NodeStream& stream) {
+        std::vector<NodeType> out;
+        for(int i = 0; i < stream.size(); i++) out.push_back(stream.getType(i));
+        return out;
+    }
+
+    std::vector<std::vector<NodeType>> declarations(const std::vector<std::string>& lines, bool threaded) {
+        nvyc::CompilationContext context("lexerStream");
+        nvyc::LexerStream source(context, lines, nullptr, threaded, 2);
+
+        std::vector<std::vector<NodeType>> out;
+        while(std::unique_ptr<NodeStream> declaration = source.next()) {
+            out.push_back(types(*declaration));
+        }
+        NVY_CHECK(source.next() == nullptr);
+        return out;
+    }
+
+    // Same declarations both ways, and nothing lost or duplicated against the whole-file lex
+    std::vector<std::vector<NodeType>> split(const std::vector<std::string>& lines) {
+        auto direct = declarations(lines, false);
+        auto threaded = declarations(lines, true);
+        NVY_CHECK(direct == threaded);
+
+        nvyc::CompilationContext context("lexerStream");
+        std::unique_ptr<NodeStream> whole(nvyc::Lexer::getInstance().lex(context, lines));
+        std::vector<NodeType> joined;
+        for(const auto& declaration : direct) joined.insert(joined.end(), declaration.begin(), declaration.end());
+        NVY_CHECK(joined == types(*whole));
+
+        return direct;
+    }
+
+    void structTrailingSemicolon() {
+        auto out = split({
+            "struct P { int32 x; int32 y; };",
+            "let z = 1;"
+        });
+        NVY_CHECK(out.size() == 2);
+        if(out.size() != 2) return;
+        NVY_CHECK(out[0].size() >= 2);
+        NVY_CHECK(out[0][out[0].size() - 2] == NodeType::CLOSEBRACE);
+        NVY_CHECK(out[0].back() == NodeType::ENDOFLINE);
+        NVY_CHECK(out[1].back() == NodeType::ENDOFLINE);
+    }
+
+    // The ';' is only lexed with the next line, the brace must wait for it
+    void semicolonOnNextLine() {
+        auto out = split({
+            "struct P {",
+            "    int32 x;",
+            "}",
+            ";",
+            "let z = 1;"
+        });
+        NVY_CHECK(out.size() == 2);
+        if(out.size() != 2) return;
+        NVY_CHECK(out[0].back() == NodeType::ENDOFLINE);
+        NVY_CHECK(out[1].front() != NodeType::ENDOFLINE);
+    }
+
+    void endOfFileWithoutTerminator() {
+        auto out = split({
+            "let y = 2;",
+            "let z = 1"
+        });
+        NVY_CHECK(out.size() == 2);
+        if(out.size() != 2) return;
+        NVY_CHECK(out[1].back() != NodeType::ENDOFLINE);
+
+        // A brace closed on the last line has no next token to wait for
+        out = split({
+            "func f() -> int32 {",
+            "    return 1;",
+            "}"
+        });
+        NVY_CHECK(out.size() == 1);
+        if(out.size() == 1) NVY_CHECK(out[0].back() == NodeType::CLOSEBRACE);
+    }
+
+    // Functions inside the module are not cut out of it
+    void moduleBlock() {
+        auto out = split({
+            "module m {",
+            "    func a() -> int32 {",
+            "        return 1;",
+            "    }",
+            "    func b() -> int32 { return 2; }",
+            "}",
+            "let z = 1;"
+        });
+        NVY_CHECK(out.size() == 2);
+        if(out.size() != 2) return;
+        NVY_CHECK(out[0].back() == NodeType::CLOSEBRACE);
+    }
+
+    // The producer fills a 1 slot ring and blocks, the destructor has to wake it to join
+    void destroyMidInput() {
+        std::vector<std::string> lines;
+        for(int i = 0; i < 1000; i++) lines.push_back("let x" + std::to_string(i) + " = " + std::to_string(i) + ";");
+
+        for(int taken : {0, 1, 10}) {
+            nvyc::CompilationContext context("lexerStream");
+            nvyc::LexerStream source(context, lines, nullptr, true, 1);
+            for(int i = 0; i < taken; i++) NVY_CHECK(source.next() != nullptr);
+        }
+    }
+
+}
+
+int main() {
+    structTrailingSemicolon();
+    semicolonOnNextLine();
+    endOfFileWithoutTerminator();
+    moduleBlock();
+    destroyMidInput();
+    return nvyc::test::finish("test_lexer_stream");
+}